@@ -0,0 +1,13 @@
+#ifndef ALLOCCOUNT_H
+#define ALLOCCOUNT_H
+
+#include <cstdint>
+
+// Process-wide heap allocation counters, kept by the global operator new that
+// alloccount.cpp replaces. Only tools that measure allocations link it.
+namespace AllocCount {
+    uint64_t allocations();
+    uint64_t bytes();
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Handed to a benchmark body. Setup goes before the loop, the measured work
+// inside it:
+//     while (state.keep_running()) { ... }
+class BenchState {
+public:
+    explicit BenchState(int64_t iterations);
+    bool keep_running();
+    // Excludes occasional bookkeeping inside the loop from the measurement.
+    void pause_timing();
+    void resume_timing();
+    void set_items_processed(int64_t items) { items_ = items; }
+    void set_bytes_processed(int64_t bytes) { bytes_ = bytes; }
+    int64_t get_iterations() const { return iterations_; }
+    int64_t get_elapsed_ns() const { return elapsed_ns_; }
+    int64_t get_items_processed() const { return items_; }
+    int64_t get_bytes_processed() const { return bytes_; }
+    // Heap allocations made while timing was running.
+    int64_t get_allocations() const { return allocations_; }
+
+private:
+    int64_t iterations_;
+    int64_t remaining_;
+    int64_t start_ns_;
+    int64_t elapsed_ns_;
+    uint64_t start_allocations_;
+    int64_t allocations_;
+    int64_t items_;
+    int64_t bytes_;
+    bool started_;
+};
+
+struct BenchOptions {
+    std::string filter;       // Run only benchmarks whose name contains this
+    double min_time = 0.5;    // Seconds each repetition should at least run
+    int repetitions = 3;
+};
+
+// In-tree microbenchmark runner. Each benchmark is calibrated to an iteration
+// count that runs for min_time, then repeated; results come back as JSON so
+// runs from different commits can be diffed.
+class BenchSuite {
+public:
+    void add(const std::string& name, std::function<void(BenchState&)> body);
+    nlohmann::json run(const BenchOptions& options) const;
+
+private:
+    struct Benchmark {
+        std::string name;
+        std::function<void(BenchState&)> body;
+    };
+    std::vector<Benchmark> benchmarks_;
+};
+
+// Defined in bench_renderer.cpp when the SDL client is built.
+void add_renderer_benchmarks(BenchSuite& suite);
+
+#endif
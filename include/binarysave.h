@@ -0,0 +1,139 @@
+#ifndef BINARYSAVE_H
+#define BINARYSAVE_H
+
+#include "game.h"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Binary save format. The file is a header followed by sections of
+// fixed-width little-endian records, laid out so a mapped file can be read in
+// place. Item and flame names live in a string table; records refer to them by
+// table index, so ids are remapped by name on load and the registry may change
+// between versions.
+//
+// Compatibility: every section records its stride. A later version may append
+// members to a record; migrate() widens older files to the current strides and
+// zero-fills the new members. Any change that is not additive bumps VERSION
+// and adds an explicit step to migrate().
+namespace BinarySave {
+    static_assert(std::endian::native == std::endian::little, "binary saves are little-endian");
+
+    constexpr char MAGIC[8] = {'A', 'L', 'C', 'H', 'S', 'A', 'V', '\0'};
+    constexpr uint32_t VERSION = 1;
+
+    struct Section {
+        uint64_t offset; // From the start of the file; 8-byte aligned
+        uint32_t count;
+        uint32_t stride; // Bytes per record; 0 for the string table
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_bytes;
+        uint64_t checksum;   // Over every byte after the header
+        uint64_t file_bytes;
+        Section state;       // One StateRecord
+        Section fields;      // FieldRecord per plot, row-major
+        Section inventory;   // InventoryRecord per item
+        Section names;       // NameRecord index followed by the characters
+    };
+
+    struct StateRecord {
+        int64_t time;
+        int64_t saved_at;       // Unix ms, 0 when not stamped
+        int64_t refine_done_at;
+        uint64_t seed;
+        uint64_t rng_state[4];
+        int32_t width;
+        int32_t height;
+        int32_t proficiency;
+        uint32_t refine_recipe;
+        uint16_t flame;         // Name index
+        uint8_t refining;
+        uint8_t reserved[5];
+        uint64_t state_hash;    // Game::get_state_hash() at save; 0 in files written before it
+    };
+
+    constexpr uint8_t FIELD_READY = 1;
+
+    struct FieldRecord {
+        int64_t ready_at;
+        uint16_t crop;          // Name index; the empty item for an empty plot
+        uint8_t flags;
+        uint8_t reserved[5];
+    };
+
+    struct InventoryRecord {
+        uint16_t item;          // Name index
+        uint16_t reserved;
+        int32_t count;
+    };
+
+    struct NameRecord {
+        uint32_t offset;        // From the start of the names section
+        uint32_t length;
+    };
+
+    static_assert(sizeof(Header) == 96 && sizeof(StateRecord) == 96 && sizeof(FieldRecord) == 16 &&
+                  sizeof(InventoryRecord) == 8 && sizeof(NameRecord) == 8, "record layouts are part of the file format");
+
+    std::string encode(const Game& game, int64_t saved_at_ms = 0);
+    void encode(const Game& game, int64_t saved_at_ms, std::string& out);
+    bool is_binary(const uint8_t* data, size_t size);
+    bool needs_migration(const uint8_t* data, size_t size);
+    // Rewrites an older file in the current layout. Fails on files from a newer version.
+    bool migrate(std::vector<uint8_t>& buffer, std::string& error);
+
+    // Read-only view over an encoded save, usually a mapped file. open()
+    // validates the header, section bounds and checksum; the accessors then
+    // read records in place without copying.
+    class View {
+    public:
+        bool open(const uint8_t* data, size_t size, std::string& error);
+        const Header& header() const { return *reinterpret_cast<const Header*>(data_); }
+        const StateRecord& state() const { return at<StateRecord>(header().state, 0); }
+        size_t field_count() const { return header().fields.count; }
+        const FieldRecord& field(size_t i) const { return at<FieldRecord>(header().fields, i); }
+        size_t inventory_count() const { return header().inventory.count; }
+        const InventoryRecord& inventory(size_t i) const { return at<InventoryRecord>(header().inventory, i); }
+        size_t name_count() const { return header().names.count; }
+        std::string_view name(size_t i) const;
+        // Builds the game the view describes; names the registry no longer knows are dropped.
+        void apply(Game& game) const;
+
+    private:
+        template <typename T>
+        const T& at(const Section& section, size_t i) const {
+            return *reinterpret_cast<const T*>(data_ + section.offset + i * section.stride);
+        }
+
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // A whole file mapped read-only (or read into memory where mapping is unavailable).
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        bool open(const std::string& path);
+        const uint8_t* data() const { return data_; }
+        size_t size() const { return size_; }
+
+    private:
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+        std::vector<uint8_t> fallback_;
+    };
+
+    uint64_t checksum(const uint8_t* data, size_t size);
+}
+
+#endif
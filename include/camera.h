@@ -0,0 +1,59 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "constants.h"
+#include <cstddef>
+
+// Maps between screen pixels and farm plots. The farm is laid out as a world
+// of FIELD_SPACING-pixel cells, each holding a FIELD_SIZE plot; the camera
+// shows the part of it under a viewport at some zoom. At zoom 1 with the
+// origin at 0 this is the fixed layout the field screen always had.
+//
+// The grid is its own spatial index: a screen point resolves to a plot, and a
+// viewport to a row/column range, by arithmetic alone, so clicks and culling
+// cost the same on a 4x4 farm and a million-plot one.
+class Camera {
+public:
+    struct Rect {
+        int x, y, w, h;
+    };
+    // Plots (or blocks) [col0, col1) x [row0, row1).
+    struct Range {
+        int col0, row0, col1, row1;
+    };
+
+    Camera();
+    void set_viewport(const Rect& viewport) { viewport_ = viewport; }
+    const Rect& get_viewport() const { return viewport_; }
+    double get_zoom() const { return zoom_; }
+    double plot_pixels() const { return Constants::FIELD_SPACING * zoom_; }
+
+    void pan(double dx, double dy); // In screen pixels
+    // Scales by factor about the screen point (x, y), which stays over the same world point.
+    void zoom_at(double factor, int x, int y);
+    // Keeps the farm in reach: zoom between fitting it twice over and the maximum,
+    // and at least part of it inside the viewport.
+    void clamp(int width, int height);
+    void reset();
+
+    // Plot whose cell (plot and the gap after it) is under a screen point, or
+    // NPOS for a point outside the viewport or off the farm.
+    size_t plot_at(int x, int y, int width, int height) const;
+    // Cells of block x block plots that overlap the viewport, clipped to the farm.
+    Range visible(int width, int height, int block = 1) const;
+    // Screen rect of the cell at (col, row) in units of block plots. Plots
+    // keep their gap only while it is at least a pixel wide.
+    Rect cell_rect(int col, int row, int block = 1) const;
+    // Plots per side of a level-of-detail tile, or 1 when plots are large enough to draw one by one.
+    int lod_block() const;
+
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+private:
+    Rect viewport_;
+    double origin_x_; // World pixel at the viewport's top-left corner
+    double origin_y_;
+    double zoom_;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include "constants.h"
+#include "game.h"
+#include "saveservice.h"
+#include "snapshot.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct ClientOptions {
+    double tick_rate = Constants::TICK_RATE;
+    double target_fps = Constants::TARGET_FPS; // 0 disables the frame limiter
+    bool vsync = Constants::USE_VSYNC;
+    bool adaptive = Constants::ADAPTIVE_LOOP;
+    bool software = false;   // SDL's software renderer, for headless runs
+    int uncapped_ticks = 0;  // Above 0 the simulation runs this many ticks per step, as fast as it can
+    bool seeded = false;
+    uint64_t seed = 0;
+    std::string record_path; // Input log for alchemist_sim --replay
+    std::string trace_path;  // Chrome trace of the profiling zones, written on exit
+    std::string save_path = Constants::SAVE_FILE;
+};
+
+// What a finished run left behind, for drivers that report on it.
+struct ClientSummary {
+    int64_t ticks = 0;
+    GameStats game;
+    SaveStats saves;
+    uint64_t journal_bytes = 0;
+    double first_frame_ms = 0.0; // From run_client() to the first frame presented
+};
+
+// Called on the render thread at the top of every loop iteration with the
+// snapshot about to be drawn; a driver can push SDL events from it.
+using FrameHook = std::function<void(const RenderSnapshot&)>;
+
+// The interactive game: window, simulation thread, journal and saves, run
+// until the window is closed (or an SDL_QUIT arrives). Returns the process
+// exit code. alchemist runs it for a player; alchemist_soak runs the same
+// loop with scripted input.
+int run_client(const ClientOptions& options, const FrameHook& before_frame = nullptr, ClientSummary* summary = nullptr);
+
+#endif
@@ -2,16 +2,17 @@
 #define CONSTANTS_H
 
 #include <string>
-#include <map>
-#include <SDL2/SDL.h>
+#include <cstddef>
 
 namespace Constants {
     // Game logic constants
-    constexpr int FIELD_COUNT = 16;
-    constexpr int GRID_SIZE = 4;
+    constexpr int GRID_SIZE = 4; // Side of a new farm; loaded farms take their size from the save
+    constexpr int MAX_FARM_SIDE = 4096; // Largest width or height a save may ask for, checked before allocating
+    constexpr int FIELD_BLOCK = 16; // Plots per side of a summary block (at most 256 per block)
     constexpr double DEFAULT_GROWTH_TIME = 10.0;
     constexpr double PEST_CHECK_INTERVAL = 5.0;
     constexpr double PEST_ATTACK_PROBABILITY = 0.01;
+    constexpr double PEST_PLOT_LOSS_PROBABILITY = 1.0; // Chance each growing plot is lost in an attack
     constexpr double REFINE_TIME = 5.0;
     constexpr int FIRE_GRASS_REQUIRED = 2;
     constexpr double BASE_SUCCESS_RATE = 0.5;
@@ -42,6 +43,16 @@ namespace Constants {
     constexpr int INVENTORY_START_Y = 50;
     constexpr int TEXT_HEIGHT = 30;
     constexpr int FONT_SIZE = 24;
+    constexpr int STATS_X = 10;
+    constexpr int STATS_Y = WINDOW_HEIGHT - 30;
+    constexpr double CAMERA_MIN_ZOOM = 1.0 / 4096;
+    constexpr double CAMERA_MAX_ZOOM = 4.0;
+    constexpr double CAMERA_ZOOM_STEP = 1.25;    // Per mouse wheel notch
+    constexpr double CAMERA_PAN_STEP = 40.0;     // Screen pixels per arrow key press
+    constexpr double LOD_MIN_PLOT_PIXELS = 4.0;  // Smaller plots are drawn as summary tiles
+    constexpr double LOD_MIN_TILE_PIXELS = 4.0;
+    constexpr int SPRITE_CELL = 32;          // Atlas cell size in pixels
+    constexpr int SPRITE_ATLAS_COLUMNS = 8;
     
     // Colors (RGBA)
     struct Color {
@@ -56,12 +67,43 @@ namespace Constants {
     constexpr Color CYAN = {0, 255, 255, 255};
     
     // Game timing
-    constexpr int FRAME_DELAY = 16; // ~60 FPS
+    constexpr double TICK_RATE = 60.0;          // Simulation ticks per second
+    constexpr int MAX_TICKS_PER_FRAME = 5;      // Catch-up clamp; older backlog is dropped
+    constexpr double TARGET_FPS = 60.0;         // Frame limiter target when vsync is off
+    constexpr bool USE_VSYNC = false;
+    constexpr bool ADAPTIVE_LOOP = true;        // Sleep until input or the next visible event instead of running at a fixed rate
+    constexpr double IDLE_MAX_SLEEP = 1.0;      // Longest simulation sleep, so the journal clock stays on schedule
+    constexpr double FRAME_LIMITER_SMOOTHING = 0.1;
+    constexpr size_t ACTION_QUEUE_CAPACITY = 256; // Input actions in flight to the simulation thread; power of two
     constexpr double MILLISECONDS_TO_SECONDS = 1000.0;
+    constexpr double NANOSECONDS_PER_SECOND = 1e9;
+    
+    // Save service
+    constexpr double SAVE_INTERVAL = 2.0; // Seconds between coalesced writes
+    constexpr size_t SAVE_QUEUE_CAPACITY = 4;
+    constexpr double SNAPSHOT_INTERVAL = 60.0;          // Seconds between snapshots when the journal is on
+    constexpr uint64_t JOURNAL_COMPACT_BYTES = 1 << 20; // Journal size that forces an early snapshot
+    constexpr double JOURNAL_CLOCK_INTERVAL = 1.0;      // Game seconds between clock records while idle
+
+    // Farm host
+    constexpr size_t FARM_CHUNK_BYTES = 256 * 1024; // Farm state per work chunk, sized to stay in L2
+    constexpr size_t FARM_CHUNKS_PER_THREAD = 4;    // Lower bound on chunks so idle workers can steal
+
+    // Profiler
+    constexpr size_t PROFILE_BUFFER_CAPACITY = 4096;   // Zone events per thread between collects; power of two
+    constexpr size_t PROFILE_WINDOW = 256;             // Recent samples per zone behind the overlay percentiles
+    constexpr size_t PROFILE_TRACE_CAPACITY = 1 << 20; // Events kept for trace export
+    constexpr int PROFILE_OVERLAY_X = 10;
+    constexpr int PROFILE_OVERLAY_Y = 470;
     
     // File paths
     const std::string SAVE_FILE = "save.json";
+    constexpr size_t SAVE_FIELD_JSON_BYTES = 160; // Typical size of one field in save.json, to presize the buffer
+    const std::string SAVE_TEMP_SUFFIX = ".tmp";
+    const std::string BINARY_SAVE_SUFFIX = ".bin";
+    const std::string JOURNAL_SUFFIX = ".journal"; // Segments are <save>.journal.<n>
     const std::string FONT_PATH = "assets/font.ttf";
+    const std::string SPRITE_ATLAS_PATH = "assets/sprites.png";
     
     // Default flame types
     const std::string LOW_FLAME = "low";
@@ -73,20 +115,10 @@ namespace Constants {
     const std::string WOOD_GRASS = "wood_grass";
     const std::string PILL = "pill";
     const std::string EMPTY = "empty";
-    
-    // Default inventory
-    const std::map<std::string, int> DEFAULT_INVENTORY = {
-        {FIRE_GRASS, 0},
-        {WOOD_GRASS, 0},
-        {PILL, 0}
-    };
+
     
     // JSON formatting
     constexpr int JSON_INDENT = 4;
-        
-    inline SDL_Color toSDLColor(const Color& color) {
-        return SDL_Color{color.r, color.g, color.b, color.a};
-    }
 }
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef FARMHOST_H
+#define FARMHOST_H
+
+#include "game.h"
+#include "threadpool.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct FarmTickStats {
+    uint64_t ticks = 0;
+    int64_t last_ns = 0;  // Wall time of the most recent tick
+    int64_t max_ns = 0;
+    int64_t total_ns = 0;
+};
+
+// Owns many independent farms and advances them together on a work-stealing
+// pool. Farms never share state, so each one is updated by exactly one worker
+// per tick. tick() is the barrier: when it returns no worker touches any farm,
+// so the caller may inspect, snapshot or save them until the next tick.
+class FarmHost {
+public:
+    explicit FarmHost(size_t threads = std::thread::hardware_concurrency());
+    // Invalidates references returned by farm(); add farms before ticking.
+    size_t add_farm(int width, int height, uint64_t seed = Rng::random_seed());
+    size_t size() const { return farms_.size(); }
+    Game& farm(size_t index) { return farms_[index]; }
+    const Game& farm(size_t index) const { return farms_[index]; }
+
+    void tick(double dt);
+    // Calls before(farm) on the farm's worker right ahead of its update, e.g. to
+    // apply player input. It may only touch the farm it is given.
+    void tick(double dt, const std::function<void(Game&)>& before);
+
+    size_t get_threads() const { return pool_.size(); }
+    size_t get_chunk_size() const { return chunk_size_; }
+    uint64_t get_steals() const { return pool_.get_steals(); }
+    const FarmTickStats& get_tick_stats() const { return stats_; }
+
+private:
+    void update_chunk_size();
+
+    ThreadPool pool_;
+    std::vector<Game> farms_;
+    size_t farm_bytes_; // Largest farm's footprint, for chunk sizing
+    size_t chunk_size_;
+    FarmTickStats stats_;
+};
+
+#endif
@@ -2,24 +2,95 @@
 #define FIELD_H
 
 #include "constants.h"
-#include <string>
-#include <chrono>
+#include "gametime.h"
+#include "registry.h"
+#include <cstdint>
+#include <vector>
 
-class Field {
+// Structure-of-arrays storage for every plot of a farm. Plot state lives in
+// three bitsets (empty, growing, ready) so sweeps such as pest attacks and
+// ready scans run a 64-bit word at a time, and each plot costs a 2-byte
+// ItemId, an 8-byte ready time and three state bits.
+//
+// Ready and growing counts are also kept per square block of FIELD_BLOCK
+// plots a side, updated as plots change, so a zoomed-out view can summarize
+// any region by reading blocks instead of plots.
+//
+// The plots' share of the game state hash is kept the same way: every change
+// XORs the plot's old key out and its new one in.
+//
+// Every change also stamps its block with a new store version, so a copy
+// that remembers the version it was taken at can refresh only the blocks
+// changed since. The id tells stores apart; copies of a store share it.
+class FieldStore {
 public:
-    Field();
-    void plant(const std::string& type, double growth_time = Constants::DEFAULT_GROWTH_TIME);
-    void update(double dt);
-    bool harvest(std::string& harvested_type);
-    bool is_empty() const { return type_ == Constants::EMPTY; }
-    bool is_ready() const { return ready_; }
-    const std::string& get_type() const { return type_; }
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+    FieldStore(int width = Constants::GRID_SIZE, int height = Constants::GRID_SIZE);
+    int get_width() const { return width_; }
+    int get_height() const { return height_; }
+    size_t size() const { return size_; }
+
+    bool is_empty(size_t i) const { return test(empty_, i); }
+    bool is_growing(size_t i) const { return test(growing_, i); }
+    bool is_ready(size_t i) const { return test(ready_, i); }
+    ItemId get_crop(size_t i) const { return crops_[i]; }
+    GameTime get_ready_at(size_t i) const { return ready_at_[i]; }
+
+    void plant(size_t i, ItemId crop, GameTime ready_at);
+    void restore(size_t i, ItemId crop, GameTime ready_at, bool ready);
+    bool mature(size_t i, GameTime now);   // Growing -> ready once ready_at has passed
+    ItemId harvest(size_t i);              // Returns the crop, or EMPTY_ITEM if the plot was not ready
+    size_t clear_growing(const uint64_t* mask = nullptr); // Pest sweep over growing plots (optionally masked); returns plots lost
+    size_t word_count() const { return growing_.size(); }
+    size_t count_ready() const { return count(ready_); }
+    size_t count_growing() const { return count(growing_); }
+    size_t next_ready(size_t from) const { return next(ready_, from); }
+    size_t next_empty(size_t from) const { return next(empty_, from); }
+    size_t memory_bytes() const;
+    uint64_t get_hash() const { return hash_; }
+    uint64_t compute_hash() const; // Over every plot, to check get_hash()
+
+    int blocks_wide() const { return blocks_wide_; }
+    int blocks_high() const { return blocks_high_; }
+    size_t block_of(size_t i) const {
+        return static_cast<size_t>(i / width_ / Constants::FIELD_BLOCK) * blocks_wide_ + (i % width_) / Constants::FIELD_BLOCK;
+    }
+    int block_ready(size_t block) const { return block_ready_[block]; }
+    int block_growing(size_t block) const { return block_growing_[block]; }
+    int block_plots(size_t block) const; // Edge blocks hold fewer plots
+    uint64_t get_id() const { return id_; }
+    uint64_t get_version() const { return version_; }
+    uint64_t block_version(size_t block) const { return block_version_[block]; } // 0 until first changed
 
 private:
-    std::string type_;
-    double growth_time_;
-    std::chrono::steady_clock::time_point start_time_;
-    bool ready_;
+    static bool test(const std::vector<uint64_t>& bits, size_t i) { return (bits[i >> 6] >> (i & 63)) & 1; }
+    static void set(std::vector<uint64_t>& bits, size_t i) { bits[i >> 6] |= uint64_t(1) << (i & 63); }
+    static void reset(std::vector<uint64_t>& bits, size_t i) { bits[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    static size_t count(const std::vector<uint64_t>& bits);
+    size_t next(const std::vector<uint64_t>& bits, size_t from) const;
+
+    void count_out(size_t i); // Removes plot i from its block counts and the hash
+    void count_in(size_t i);
+    uint64_t plot_key(size_t i) const; // 0 for an empty plot
+    void touch(size_t i) { block_version_[block_of(i)] = ++version_; }
+
+    int width_;
+    int height_;
+    size_t size_;
+    int blocks_wide_;
+    int blocks_high_;
+    std::vector<ItemId> crops_;
+    std::vector<GameTime> ready_at_;
+    std::vector<uint64_t> empty_;
+    std::vector<uint64_t> growing_;
+    std::vector<uint64_t> ready_;
+    std::vector<uint16_t> block_ready_;
+    std::vector<uint16_t> block_growing_;
+    std::vector<uint64_t> block_version_;
+    uint64_t hash_;
+    uint64_t id_;
+    uint64_t version_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -3,35 +3,108 @@
 
 #include "field.h"
 #include "constants.h"
+#include "gametime.h"
+#include "scheduler.h"
+#include "rng.h"
+#include "registry.h"
 #include <vector>
-#include <map>
 #include <string>
+#include <cstdint>
+
+// Debug switch: 1 recomputes the state hash from scratch after every change
+// and aborts on a mismatch with the incremental one. O(plots) per change.
+#ifndef ALCHEMIST_CHECK_HASH
+#define ALCHEMIST_CHECK_HASH 0
+#endif
+
+// Lifetime counters, used by the headless simulator to report balance numbers.
+struct GameStats {
+    uint64_t plants = 0;
+    uint64_t harvests = 0;
+    uint64_t refines_started = 0;
+    uint64_t refines_succeeded = 0;
+    uint64_t refines_failed = 0;
+    uint64_t pest_attacks = 0;
+    uint64_t fields_lost = 0;
+};
 
 class Game {
 public:
-    Game();
+    Game(int width = Constants::GRID_SIZE, int height = Constants::GRID_SIZE, uint64_t seed = Rng::random_seed());
     void update(double dt);
-    bool plant(int idx, const std::string& type);
-    bool harvest(int idx, std::string& harvested_type);
+    // Runs every event due up to time; update(dt) is advance_to(now + dt).
+    void advance_to(GameTime time);
+    // Fast-forwards an absence of any length, e.g. offline time on load. It jumps
+    // from event to event and draws the gap to the next pest attack in one roll
+    // instead of rolling every check, so the cost follows the number of attacks.
+    void advance(double seconds);
+    bool plant(int idx, ItemId crop);
+    bool harvest(int idx, ItemId& harvested);
     bool start_refining();
-    void set_flame_type(const std::string& flame);
-    const std::vector<Field>& get_fields() const { return fields_; }
-    std::vector<Field>& get_fields() { return fields_; }
-    const std::map<std::string, int>& get_inventory() const { return inventory_; }
-    std::map<std::string, int>& get_inventory() { return inventory_; }
-    const std::string& get_flame_type() const { return flame_type_; }
+    // True when some recipe's inputs are in the inventory and nothing is refining.
+    bool can_refine() const { return !refining_ && find_recipe() != NO_RECIPE; }
+    void set_flame_type(FlameId flame);
+    const FieldStore& get_fields() const { return fields_; }
+    const Inventory& get_inventory() const { return inventory_; }
+    FlameId get_flame_type() const { return flame_type_; }
+    const std::string& get_flame_name() const { return Registry::get().flame(flame_type_).name; }
     int get_proficiency() const { return proficiency_; }
-    void set_proficiency(int proficiency) { proficiency_ = proficiency; }
+    void set_proficiency(int proficiency);
+    // Bumped on every state change that should be persisted.
+    uint64_t get_revision() const { return revision_; }
+    // Zobrist-style hash of what the player has built up: plots, inventory,
+    // proficiency, flame and refining. The clock and rng are left out since
+    // they move without the player doing anything. Maintained as state
+    // changes, so equal hashes (barring collisions) mean equal state in O(1).
+    uint64_t get_state_hash() const { return fields_.get_hash() ^ inventory_.get_hash() ^ scalar_hash(); }
+    // The same hash recomputed from scratch, O(plots).
+    uint64_t compute_state_hash() const { return fields_.compute_hash() ^ inventory_.compute_hash() ^ scalar_hash(); }
+    const GameStats& get_stats() const { return stats_; }
+    bool is_refining() const { return refining_; }
+    GameTime get_time() const { return now_; }
+    GameTime get_refine_done_at() const { return refine_done_at_; }
+    // Earliest time an event can change what the player sees: a plot ripening,
+    // refining finishing, or a pest check while anything grows. GAME_TIME_NEVER
+    // when there is none. Quieter events (pest checks over a bare field) still
+    // fire on time whenever the clock is ticked past them.
+    GameTime next_wake_time() const;
+    // Save-file boundary: restores clock and field growth without counting as changes.
+    void set_time(GameTime now);
+    const Rng& get_rng() const { return rng_; }
+    void seed_rng(uint64_t seed) { rng_.seed(seed); }
+    void set_rng_state(uint64_t seed, const Rng::State& state);
+    bool restore_field(int idx, ItemId crop, GameTime ready_at, bool ready);
+    bool restore_refining(size_t recipe, GameTime done_at);
+    size_t get_refine_recipe() const { return refine_recipe_; }
+    void restore_item_count(ItemId item, int count) { inventory_.set(item, count); }
 
 private:
+    static constexpr size_t NO_RECIPE = SIZE_MAX;
+    size_t find_recipe() const;
     bool refine();
-    std::vector<Field> fields_;
-    std::map<std::string, int> inventory_;
+    void handle_event(const ScheduledEvent& event);
+    void check_pests();
+    void pest_attack();
+    uint64_t scalar_hash() const; // Proficiency, flame and refining
+#if ALCHEMIST_CHECK_HASH
+    void check_state_hash(const char* after) const;
+#else
+    void check_state_hash(const char*) const {}
+#endif
+    GameTime now_;
+    GameTime skip_pests_until_; // Inside advance(): pest checks up to here are drawn in bulk
+    Scheduler scheduler_;
+    Rng rng_;
+    std::vector<uint64_t> pest_mask_; // Scratch for per-plot pest rolls
+    FieldStore fields_;
+    Inventory inventory_;
     int proficiency_;
     bool refining_;
-    double refine_time_;
-    std::string flame_type_;
-    double pest_timer_;
+    size_t refine_recipe_; // Index into Registry::recipes() while refining
+    GameTime refine_done_at_;
+    FlameId flame_type_;
+    uint64_t revision_;
+    GameStats stats_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef GAMETIME_H
+#define GAMETIME_H
+
+#include "constants.h"
+#include <cmath>
+#include <cstdint>
+
+// Virtual time owned by Game, in nanoseconds since the farm was created. It only
+// advances through Game::update, so it can be saved and run faster than real time.
+using GameTime = int64_t;
+
+constexpr GameTime GAME_TIME_NEVER = INT64_MAX;
+
+inline GameTime to_game_time(double seconds) {
+    return static_cast<GameTime>(std::llround(seconds * Constants::NANOSECONDS_PER_SECOND));
+}
+
+inline double to_seconds(GameTime time) {
+    return static_cast<double>(time) / Constants::NANOSECONDS_PER_SECOND;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "game.h"
+#include "replay.h"
+#include "constants.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Write-ahead log of everything that changed the game since the last snapshot.
+// Each successful command is appended as a compact binary record and flushed,
+// and so are the random outcomes (refine results, pest losses) as checks for
+// the replay. A segment starts with a header naming the state it continues
+// from (game time and RNG state), so recovery can chain segments onto
+// whichever snapshot actually made it to disk and skip stale ones.
+//
+// Durability: every record is flushed to the OS as it is written, so it
+// survives the process crashing. Segments are fsynced only when they end
+// (rotate() and close()), so a power loss or OS crash can lose the records
+// of the segment still being written.
+class Journal {
+public:
+    explicit Journal(const std::string& save_path = Constants::SAVE_FILE);
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Opens a fresh segment continuing from base, which must already be saved;
+    // segments left on disk from earlier runs are deleted.
+    bool open(const Game& base);
+    void close();
+    void record(const Game& game, const Command& command); // After the command succeeded
+    void observe(const Game& game);                         // After ticks; journals new outcomes
+    // Called when a snapshot of base was queued: later records go to a new segment.
+    bool rotate(const Game& base);
+    // Deletes segments that the snapshot with this revision makes redundant.
+    void retire(uint64_t saved_revision);
+    uint64_t get_segment_bytes() const { return segment_bytes_; }
+    uint64_t get_bytes_written() const { return bytes_written_; } // Across all segments since construction
+
+    // Replays every segment that continues from the game's current state, in
+    // order. Returns the number of records applied.
+    static size_t recover(const std::string& save_path, Game& game);
+
+private:
+    struct Segment {
+        uint64_t number;
+        uint64_t base_revision;
+        std::string path;
+    };
+
+    bool start_segment(uint64_t number, const Game& base);
+    void append(uint8_t type, const Game& game, std::initializer_list<uint64_t> values);
+    static std::vector<std::pair<uint64_t, std::string>> list_segments(const std::string& save_path);
+
+    std::string save_path_;
+    std::FILE* file_;
+    std::vector<Segment> segments_;
+    GameTime last_time_;
+    GameStats last_stats_;
+    uint64_t segment_bytes_;
+    uint64_t bytes_written_;
+};
+
+#endif
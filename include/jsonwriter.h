@@ -0,0 +1,55 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include "constants.h"
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Streams pretty-printed JSON straight into a caller-owned buffer, with the
+// same layout as nlohmann::json::dump(indent): one member or element per line
+// and empty containers written as {} and []. Keys are written in the order
+// given, so callers that need dump()'s output emit object members sorted.
+// Appending to a reused buffer allocates only when it has to grow.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out, int indent = Constants::JSON_INDENT) : out_(out), indent_(indent), depth_(0), after_key_(false) {}
+
+    void begin_object() { open('{'); }
+    void end_object() { close('}'); }
+    void begin_array() { open('['); }
+    void end_array() { close(']'); }
+    void key(std::string_view name);
+
+    void value(bool b);
+    void value(double d);
+    void value(std::string_view s);
+    void value(const char* s) { value(std::string_view(s)); }
+    void value(const std::string& s) { value(std::string_view(s)); }
+    template <std::integral T>
+    void value(T n) {
+        separate();
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), n);
+        out_.append(buffer, result.ptr);
+    }
+
+private:
+    static constexpr size_t MAX_DEPTH = 16;
+
+    void open(char bracket);
+    void close(char bracket);
+    void separate(); // Comma and line break before an element; nothing after a key
+    void newline(size_t depth);
+
+    std::string& out_;
+    int indent_;
+    size_t depth_;
+    bool after_key_;
+    std::array<uint32_t, MAX_DEPTH> counts_; // Elements written per open container
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Compile-time floor for log records: 0 trace, 1 debug, 2 info, 3 warn, 4 error, 5 off.
+#ifndef ALCHEMIST_LOG_LEVEL
+#define ALCHEMIST_LOG_LEVEL 2
+#endif
+
+namespace Log {
+    enum class Level : uint8_t { TRACE, DEBUG, INFO, WARN, ERROR, OFF };
+
+    // The floor is compared as a signed difference: a plain >= against level 0
+    // is always true for the unsigned level type and trips -Wtype-limits.
+    constexpr bool enabled(Level level) {
+        return static_cast<int>(level) - ALCHEMIST_LOG_LEVEL > -1 && level != Level::OFF;
+    }
+
+    // A typed key/value attached to a record. Text is copied (truncated) so the
+    // record owns everything it needs once it is in the ring buffer.
+    struct Field {
+        static constexpr size_t TEXT_CAPACITY = 40;
+        enum class Kind : uint8_t { INT, UINT, DOUBLE, TEXT };
+
+        Field() : key(nullptr), kind(Kind::INT), i(0) {}
+        Field(const char* key, int value) : key(key), kind(Kind::INT), i(value) {}
+        Field(const char* key, long value) : key(key), kind(Kind::INT), i(value) {}
+        Field(const char* key, long long value) : key(key), kind(Kind::INT), i(value) {}
+        Field(const char* key, unsigned long value) : key(key), kind(Kind::UINT), u(value) {}
+        Field(const char* key, unsigned long long value) : key(key), kind(Kind::UINT), u(value) {}
+        Field(const char* key, double value) : key(key), kind(Kind::DOUBLE), d(value) {}
+        Field(const char* key, std::string_view value);
+        Field(const char* key, const char* value) : Field(key, std::string_view(value)) {}
+        Field(const char* key, const std::string& value) : Field(key, std::string_view(value)) {}
+
+        const char* key; // Must be a string literal
+        Kind kind;
+        union {
+            int64_t i;
+            uint64_t u; // Hashes and seeds, which may not fit in int64_t
+            double d;
+            char text[TEXT_CAPACITY];
+        };
+    };
+
+    struct Record {
+        static constexpr size_t MAX_FIELDS = 4;
+        int64_t time_ns;
+        const char* message; // Must be a string literal
+        Level level;
+        uint8_t field_count;
+        Field fields[MAX_FIELDS];
+    };
+
+    // Drains records from a bounded lock-free ring buffer on a background
+    // thread. Producers never block: when the buffer is full the record is
+    // dropped and counted. Until start() runs (or after stop()), warnings and
+    // errors are written synchronously to stderr and everything else is dropped.
+    // stop() returns only after every push that found the logger running has
+    // been written, so no record is lost without being counted.
+    class Logger {
+    public:
+        static Logger& instance();
+        ~Logger();
+        bool start(const std::string& path = std::string()); // Empty path logs to stdout
+        void stop();
+        void push(const Record& record);
+        uint64_t get_dropped() const { return dropped_.load(std::memory_order_relaxed); }
+        uint64_t get_written() const { return written_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot;
+        Logger();
+        bool try_push(const Record& record);
+        bool try_pop(Record& record);
+        void run();
+        static void format(std::FILE* out, const Record& record);
+
+        static constexpr size_t CAPACITY = 4096; // Power of two
+        std::unique_ptr<Slot[]> slots_;
+        alignas(64) std::atomic<uint64_t> head_;
+        alignas(64) std::atomic<uint64_t> tail_;
+        alignas(64) std::atomic<bool> running_;
+        std::atomic<uint32_t> pushing_; // Pushes that found the logger running and have not finished
+        std::atomic<uint64_t> dropped_;
+        std::atomic<uint64_t> written_;
+        std::thread worker_;
+        std::FILE* out_;
+    };
+
+    // Fields are passed as braced pairs: LOG_INFO("Planted", {"type", name}, {"idx", i}).
+    void write(Level level, const char* message, const Field& a = Field(), const Field& b = Field(),
+               const Field& c = Field(), const Field& d = Field());
+}
+
+// Arguments are not evaluated when the level is compiled out.
+#define ALCHEMIST_LOG(level, ...) \
+    do { if constexpr (Log::enabled(level)) Log::write(level, __VA_ARGS__); } while (0)
+#define LOG_TRACE(...) ALCHEMIST_LOG(Log::Level::TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) ALCHEMIST_LOG(Log::Level::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) ALCHEMIST_LOG(Log::Level::INFO, __VA_ARGS__)
+#define LOG_WARN(...) ALCHEMIST_LOG(Log::Level::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) ALCHEMIST_LOG(Log::Level::ERROR, __VA_ARGS__)
+
+#endif
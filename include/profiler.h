@@ -0,0 +1,100 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "constants.h"
+#include "timing.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Compile-time switch for profiling zones; 0 removes them entirely.
+#ifndef ALCHEMIST_PROFILE
+#define ALCHEMIST_PROFILE 1
+#endif
+
+namespace Profile {
+    struct ZoneStats {
+        std::string name;
+        uint64_t count; // Samples in the window
+        double p50_ms;
+        double p99_ms;
+        double max_ms;
+    };
+
+    // Collects timed zones from any thread. Each thread writes into its own
+    // lock-free single-producer ring, so recording a zone never blocks; one
+    // thread (the main loop) drains all rings with collect() once per frame.
+    class Profiler {
+    public:
+        static Profiler& instance();
+        uint16_t register_zone(const char* name); // Once per zone site; name must be a literal
+        void record(uint16_t zone, int64_t start_ns, int64_t end_ns);
+        void name_thread(const std::string& name); // Label for the calling thread in traces
+
+        // Collector thread only.
+        void collect();
+        std::vector<ZoneStats> get_stats() const; // Over the last PROFILE_WINDOW samples per zone
+        void start_trace(size_t capacity = Constants::PROFILE_TRACE_CAPACITY);
+        bool write_trace(const std::string& path) const; // Chrome trace-event JSON
+        uint64_t get_dropped() const;
+
+    private:
+        struct Event {
+            uint16_t zone;
+            int64_t start_ns;
+            int64_t end_ns;
+        };
+        struct ThreadBuffer;
+        struct Window {
+            std::vector<int64_t> samples; // Ring of durations
+            size_t next = 0;
+        };
+        struct TraceEvent {
+            Event event;
+            uint32_t thread;
+        };
+
+        Profiler();
+        ThreadBuffer& local_buffer();
+
+        const int64_t start_ns_;
+        mutable std::mutex mutex_; // Guards zone_names_, buffers_ and thread names
+        std::vector<const char*> zone_names_;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+        std::vector<Window> windows_;
+        std::vector<ThreadBuffer*> collecting_; // collect()'s copy of buffers_, kept to reuse its storage
+        std::vector<TraceEvent> trace_;
+        size_t trace_capacity_;
+        uint64_t trace_dropped_;
+    };
+
+    // Times its own scope.
+    class Zone {
+    public:
+        explicit Zone(uint16_t id) : id_(id), start_ns_(Timing::now_ns()) {}
+        ~Zone() { Profiler::instance().record(id_, start_ns_, Timing::now_ns()); }
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        uint16_t id_;
+        int64_t start_ns_;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// PROFILE_ZONE("render") times the rest of the enclosing scope.
+#if ALCHEMIST_PROFILE
+#define PROFILE_ZONE(name) \
+    static const uint16_t PROFILE_CONCAT(profile_zone_id_, __LINE__) = Profile::Profiler::instance().register_zone(name); \
+    Profile::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(PROFILE_CONCAT(profile_zone_id_, __LINE__))
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+
+#endif
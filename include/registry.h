@@ -0,0 +1,109 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include "statehash.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using ItemId = uint16_t;
+using FlameId = uint8_t;
+
+struct FlameDef {
+    std::string name;
+    double bonus; // Added to the refine success rate
+};
+
+struct RecipeDef {
+    ItemId input;
+    int input_count;
+    ItemId output;
+    double refine_time;
+    double base_success_rate;
+};
+
+// Interns item and flame names into dense ids once at startup. Game state only
+// ever holds ids; names are looked up at the save-file and UI boundaries. The
+// registry is immutable after construction, so it is safe to share between
+// threads.
+class Registry {
+public:
+    static constexpr ItemId EMPTY_ITEM = 0; // Reserved for "no item", e.g. an empty plot
+    static constexpr ItemId INVALID_ITEM = UINT16_MAX;
+    static constexpr FlameId INVALID_FLAME = UINT8_MAX;
+
+    static const Registry& get();
+
+    size_t item_count() const { return items_.size(); }
+    const std::string& item_name(ItemId id) const { return items_[id]; }
+    ItemId find_item(std::string_view name) const;
+    // Every item but EMPTY_ITEM, sorted by name: the order lists are shown and saved in.
+    const std::vector<ItemId>& items_by_name() const { return items_by_name_; }
+    // State hash salts, keyed from the names.
+    uint64_t item_key(ItemId id) const { return item_keys_[id]; }
+    uint64_t flame_key(FlameId id) const { return flame_keys_[id]; }
+
+    size_t flame_count() const { return flames_.size(); }
+    const FlameDef& flame(FlameId id) const { return flames_[id]; }
+    FlameId find_flame(std::string_view name) const;
+    FlameId next_flame(FlameId id) const { return static_cast<FlameId>((id + 1) % flames_.size()); }
+
+    const std::vector<RecipeDef>& recipes() const { return recipes_; }
+
+    // Ids of the built-in items and flames, resolved at startup.
+    ItemId fire_grass;
+    ItemId wood_grass;
+    ItemId pill;
+    FlameId low_flame;
+
+private:
+    Registry();
+    ItemId add_item(const std::string& name);
+    FlameId add_flame(const std::string& name, double bonus);
+
+    // Transparent hashing lets find_item look up a string_view without allocating.
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    std::vector<std::string> items_;
+    std::unordered_map<std::string, ItemId, NameHash, std::equal_to<>> item_ids_;
+    std::vector<ItemId> items_by_name_;
+    std::vector<uint64_t> item_keys_;
+    std::vector<FlameDef> flames_;
+    std::vector<uint64_t> flame_keys_;
+    std::vector<RecipeDef> recipes_;
+};
+
+// Flat item counters indexed by ItemId, with their share of the state hash.
+class Inventory {
+public:
+    Inventory() : counts_(Registry::get().item_count(), 0), hash_(0) {}
+    int get(ItemId id) const { return counts_[id]; }
+    void set(ItemId id, int count) {
+        hash_ ^= key(id, counts_[id]) ^ key(id, count);
+        counts_[id] = count;
+    }
+    void add(ItemId id, int count) { set(id, counts_[id] + count); }
+    size_t size() const { return counts_.size(); }
+    uint64_t get_hash() const { return hash_; }
+    uint64_t compute_hash() const {
+        uint64_t hash = 0;
+        for (size_t id = 0; id < counts_.size(); ++id) hash ^= key(static_cast<ItemId>(id), counts_[id]);
+        return hash;
+    }
+
+private:
+    static uint64_t key(ItemId id, int count) {
+        return count == 0 ? 0 : StateHash::key(StateHash::ITEM, Registry::get().item_key(id), static_cast<uint32_t>(count));
+    }
+
+    std::vector<int> counts_;
+    uint64_t hash_;
+};
+
+#endif
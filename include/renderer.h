@@ -3,8 +3,14 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
-#include "game.h"
+#include "snapshot.h"
 #include "constants.h"
+#include "textcache.h"
+#include "spritebatch.h"
+#include "profiler.h"
+#include "camera.h"
+#include <string>
+#include <vector>
 
 enum class Screen { FIELD, INVENTORY, REFINING };
 
@@ -12,17 +18,49 @@ class Renderer {
 public:
     Renderer();
     ~Renderer();
-    bool init();
-    void render(const Game& game, Screen screen);
+    // software selects SDL's software renderer, e.g. for headless benchmarks.
+    bool init(bool vsync = Constants::USE_VSYNC, bool software = false);
+    void render(const RenderSnapshot& state, Screen screen);
+    void set_loop_stats(double fps, double tps) { fps_ = fps; tps_ = tps; }
+    void toggle_profile_overlay() { show_profile_ = !show_profile_; }
+    Camera& get_camera() { return camera_; } // Field screen view; input pans and zooms it
+    // For the adaptive loop: whether a frame drawn now would differ from the
+    // last one (input that moves the view is the caller's to track), and how
+    // long until it would on its own, or -1 for not before the next snapshot.
+    bool is_stale(const RenderSnapshot& state, Screen screen) const;
+    int64_t get_still_ns(const RenderSnapshot& state, Screen screen) const;
 
 private:
-    void render_field_screen(const Game& game);
-    void render_inventory_screen(const Game& game);
-    void render_refining_screen(const Game& game);
-    void render_navigation_buttons(Screen current_screen);
+    bool create_window(bool vsync, bool software);
+    bool load_assets(); // Opens the font and builds the glyph and sprite surfaces
+    // Rectangles are queued into the sprite batch first; the render_* text passes draw on top.
+    void queue_field_sprites(const RenderSnapshot& state);
+    void queue_refining_sprites();
+    void queue_navigation_sprites(Screen current_screen);
+    void render_field_screen(const RenderSnapshot& state);
+    void render_inventory_screen(const RenderSnapshot& state);
+    int render_inventory_text(const RenderSnapshot& state); // Returns the y below the last line
+    void render_refining_screen(const RenderSnapshot& state);
+    void render_flame_label(const RenderSnapshot& state, const SDL_Rect& dst);
+    void render_navigation_labels();
+    void render_loop_stats();
+    SDL_Rect profile_panel_rect() const;
+    void render_profile_overlay();
     SDL_Window* window_;
     SDL_Renderer* renderer_;
     TTF_Font* font_;
+    TextCache text_cache_;
+    SpriteBatch sprites_;
+    Camera camera_;
+    std::vector<Profile::ZoneStats> profile_stats_; // This frame's, when the overlay is shown
+    std::vector<std::string> inventory_keys_; // Text cache key per item, built once
+    double fps_;
+    double tps_;
+    bool show_profile_;
+    Screen drawn_screen_; // What the last frame showed
+    uint64_t drawn_revision_;
+    bool drawn_refining_;
+    int drawn_countdown_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "game.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class CommandType : uint8_t { PLANT, HARVEST, START_REFINING, SET_FLAME };
+
+// A player action, stamped with the number of simulation ticks that had run
+// when it was applied.
+struct Command {
+    int64_t tick;
+    CommandType type;
+    int32_t index; // Field index for PLANT and HARVEST
+    uint16_t id;   // ItemId for PLANT, FlameId for SET_FLAME
+};
+
+// Applies a command to the game; returns whether it changed anything.
+bool execute_command(Game& game, const Command& command);
+
+// Input log for deterministic replay. It holds the starting snapshot (which
+// carries the RNG seed and state), the fixed tick length and every command
+// that succeeded, which together reproduce a run bit for bit.
+class CommandLog {
+public:
+    CommandLog();
+    void begin(const Game& game, double tick_dt);
+    bool execute(Game& game, const Command& command); // Records the command if it succeeded
+    void finish(int64_t end_tick) { end_tick_ = end_tick; }
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    bool replay(Game& game) const;
+    size_t size() const { return commands_.size(); }
+    int64_t get_end_tick() const { return end_tick_; }
+
+private:
+    std::string snapshot_;
+    double tick_dt_;
+    int64_t end_tick_;
+    std::vector<Command> commands_;
+};
+
+#endif
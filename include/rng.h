@@ -0,0 +1,50 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// xoshiro256** seeded through splitmix64. One instance is owned per Game so
+// draws cost a few arithmetic ops, and the full state can be saved so a seed
+// plus the same inputs reproduce a run bit for bit.
+class Rng {
+public:
+    using State = std::array<uint64_t, 4>;
+
+    explicit Rng(uint64_t seed = 0);
+    void seed(uint64_t seed);
+    uint64_t get_seed() const { return seed_; }
+    const State& get_state() const { return state_; }
+    void set_state(const State& state) { state_ = state; }
+
+    uint64_t next_u64() {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+    // Uniform in [0, 1) with 53 bits of precision.
+    double next_double() { return static_cast<double>(next_u64() >> 11) * 0x1.0p-53; }
+
+    // Failures before the first success in Bernoulli(p) trials, from one draw.
+    uint64_t next_geometric(double p);
+
+    // Sets each of the first `bits` bits of `words` independently with probability p.
+    void fill_bernoulli(uint64_t* words, size_t bits, double p);
+
+    // Seed for runs that do not ask for a specific one.
+    static uint64_t random_seed();
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    uint64_t seed_;
+    State state_;
+};
+
+#endif
@@ -2,12 +2,41 @@
 #define SAVEMANAGER_H
 
 #include "game.h"
-#include <nlohmann/json.hpp>
+#include "constants.h"
+#include <string>
+#include <string_view>
 
+enum class SaveFormat {
+    JSON,
+    BINARY
+};
+
+// Single entry point for save files. The format follows the file extension
+// (Constants::BINARY_SAVE_SUFFIX for binary, JSON otherwise) on write; reads
+// detect it from the file contents.
 class SaveManager {
 public:
-    static void load(Game& game);
-    static void save(const Game& game);
+    // Reads the snapshot, replays the journal after it and fast-forwards offline time.
+    static void load(Game& game, const std::string& path = Constants::SAVE_FILE);
+    // Returns false (reporting why on stderr) if the file could not be written; the old one is left in place.
+    static bool save(const Game& game, const std::string& path = Constants::SAVE_FILE);
+    // Reads the snapshot alone; saved_at_ms receives its wall-clock stamp (0 if none).
+    static bool read(const std::string& path, Game& game, int64_t& saved_at_ms);
+    // Serializes in the format path calls for. The out overloads reuse the
+    // buffer's capacity, so a caller that keeps one allocates only as it grows.
+    static std::string encode(const Game& game, const std::string& path, int64_t saved_at_ms = 0);
+    static void encode(const Game& game, const std::string& path, int64_t saved_at_ms, std::string& out);
+    // Rewrites a save in the format of to_path, keeping its wall-clock stamp.
+    static bool convert(const std::string& from_path, const std::string& to_path);
+    static SaveFormat format_for(const std::string& path);
+    // saved_at_ms stamps the snapshot with wall-clock time so load can fast-forward
+    // the time spent offline; 0 leaves it out (digests, replay snapshots).
+    static std::string serialize(const Game& game, int64_t saved_at_ms = 0);
+    static void serialize(const Game& game, int64_t saved_at_ms, std::string& out);
+    // Streams the JSON through a SAX reader into the game; no DOM is built.
+    static bool deserialize(std::string_view data, Game& game, int64_t* saved_at_ms = nullptr);
+    // Writes data to a temp file next to path and renames it over path.
+    static bool write_atomic(const std::string& path, const std::string& data);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,67 @@
+#ifndef SAVESERVICE_H
+#define SAVESERVICE_H
+
+#include "game.h"
+#include "constants.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct SaveStats {
+    uint64_t saves_written = 0;
+    uint64_t saves_failed = 0;
+    uint64_t snapshots_coalesced = 0; // Snapshots replaced before they were written
+    uint64_t bytes_written = 0;
+    uint64_t last_revision = 0;       // Game revision of the newest snapshot on disk
+    double last_latency_ms = 0.0;     // Serialize + write + rename of the last save
+    double max_latency_ms = 0.0;
+    double total_latency_ms = 0.0;
+};
+
+// Persists Game snapshots on a background thread. poll() is cheap to call every
+// frame: it only copies the game when its revision changed and the save interval
+// has elapsed (or force is set), and a full queue keeps just the newest snapshot.
+// A snapshot whose write fails leaves the game dirty, so the next poll after
+// the interval queues it again.
+class SaveService {
+public:
+    explicit SaveService(const std::string& path = Constants::SAVE_FILE,
+                         double interval = Constants::SAVE_INTERVAL,
+                         size_t capacity = Constants::SAVE_QUEUE_CAPACITY);
+    ~SaveService();
+    void start(const Game& game);
+    bool poll(const Game& game, bool force = false); // True when a snapshot was queued
+    void flush(const Game& game); // Queues any pending change and waits for the writer to drain
+    void stop();
+    SaveStats get_stats() const;
+
+private:
+    static constexpr uint64_t NOT_QUEUED = UINT64_MAX;
+
+    bool is_dirty(const Game& game);
+    void submit(const Game& game);
+    void run();
+
+    std::string path_;
+    double interval_;
+    size_t capacity_;
+    uint64_t queued_revision_; // Newest revision handed to the writer (or written, without one)
+    std::atomic<bool> write_failed_; // Set by the writer, cleared by is_dirty()
+    std::chrono::steady_clock::time_point last_submit_;
+
+    std::thread worker_;
+    mutable std::mutex mutex_;
+    std::condition_variable queue_cv_;
+    std::condition_variable idle_cv_;
+    std::deque<Game> queue_;
+    bool writing_;
+    bool stopping_;
+    SaveStats stats_;
+};
+
+#endif
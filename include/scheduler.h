@@ -0,0 +1,39 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "gametime.h"
+#include <cstdint>
+#include <vector>
+
+// PEST_ATTACK is a pest check already known to hit, placed by Game::advance.
+enum class EventType : uint8_t { FIELD_READY, REFINE_DONE, PEST_CHECK, PEST_ATTACK };
+
+struct ScheduledEvent {
+    GameTime due;
+    uint64_t seq; // Last tie-break, after type and target
+    EventType type;
+    int32_t target; // Field index for FIELD_READY, unused otherwise
+};
+
+// Min-heap of future game events keyed on due time. Events are never removed
+// early; handlers check that the state they refer to is still current, so
+// cancelling (harvest, pest loss) costs nothing. Events due together fire in a
+// fixed order (fields ripen, then pests strike, then refining ends) that does
+// not depend on scheduling history, so a scheduler rebuilt from a save fires
+// exactly like the one it replaced.
+class Scheduler {
+public:
+    Scheduler();
+    void schedule(GameTime due, EventType type, int32_t target = 0);
+    bool pop_due(GameTime now, ScheduledEvent& event);
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+    GameTime next_due() const { return heap_.front().due; }
+    void clear();
+
+private:
+    std::vector<ScheduledEvent> heap_;
+    uint64_t next_seq_;
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef SDLCOLOR_H
+#define SDLCOLOR_H
+
+#include "constants.h"
+#include <SDL2/SDL.h>
+
+// Kept out of constants.h so the game core does not depend on SDL.
+namespace Constants {
+    inline SDL_Color toSDLColor(const Color& color) {
+        return SDL_Color{color.r, color.g, color.b, color.a};
+    }
+}
+
+#endif
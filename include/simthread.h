@@ -0,0 +1,90 @@
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include "game.h"
+#include "journal.h"
+#include "replay.h"
+#include "saveservice.h"
+#include "snapshot.h"
+#include "spscqueue.h"
+#include "triplebuffer.h"
+#include "timing.h"
+#include "constants.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <semaphore>
+#include <thread>
+
+// A player input, resolved against the live game on the simulation thread.
+enum class ActionType : uint8_t { TAP_PLOT, START_REFINING, NEXT_FLAME };
+
+struct Action {
+    ActionType type;
+    int32_t index; // Plot for TAP_PLOT
+};
+
+// Runs the game on its own thread at the fixed tick rate: applies queued
+// actions as commands, ticks, journals, hands snapshots to the save service
+// and publishes a RenderSnapshot after every step. The game, journal, save
+// service and command log belong to this thread between start() and stop();
+// the render thread only sends actions and reads snapshots, neither of which
+// takes a lock, so a slow frame or save on one side never delays the other.
+//
+// In adaptive mode the thread sleeps whenever the next visible event is more
+// than a tick away, until that event's tick, an action or IDLE_MAX_SLEEP,
+// and then runs every tick it slept through. Game time and the tick count
+// come out exactly as if it had ticked all along, so recordings still replay.
+class SimThread {
+public:
+    SimThread(Game& game, Journal& journal, SaveService& save_service, double tick_rate, CommandLog* command_log = nullptr);
+    ~SimThread();
+    SimThread(const SimThread&) = delete;
+    SimThread& operator=(const SimThread&) = delete;
+
+    // Before start(). on_change runs on the simulation thread after a publish
+    // that changed something drawn, e.g. to wake a render thread waiting for events.
+    void set_adaptive(bool adaptive) { adaptive_ = adaptive; }
+    // Above 0, every step runs exactly this many ticks with no pacing, for
+    // covering hours of play in seconds. Time then no longer follows the wall clock.
+    void set_uncapped(int ticks_per_step) { uncapped_ticks_ = ticks_per_step; }
+    void set_on_change(std::function<void()> on_change) { on_change_ = std::move(on_change); }
+    void start();
+    void stop(); // Joins the thread; the game is the caller's again afterwards
+
+    // Render thread. send() returns false (dropping the action) when the queue is full.
+    bool send(const Action& action);
+    bool refresh() { return snapshots_.update(); } // Takes the newest snapshot; true if there was one
+    const RenderSnapshot& latest() const { return snapshots_.front(); }
+
+    int64_t get_tick_count() const { return tick_count_; } // After stop()
+
+private:
+    void run();
+    void run_ticks(int64_t count, double dt);
+    void apply(const Action& action);
+    bool run_command(CommandType type, int index = 0, uint16_t id = 0);
+    void publish();
+    int64_t idle_ns(const FixedTimestep& timestep) const;
+
+    Game& game_;
+    Journal& journal_;
+    SaveService& save_service_;
+    CommandLog* command_log_;
+    double tick_rate_;
+    int64_t tick_count_;
+    double measured_tick_rate_;
+    bool adaptive_;
+    int uncapped_ticks_;
+    bool published_;
+    uint64_t published_revision_; // What the newest published snapshot shows
+    bool published_refining_;
+    std::function<void()> on_change_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+    SpscQueue<Action, Constants::ACTION_QUEUE_CAPACITY> actions_;
+    std::counting_semaphore<> wake_; // Released per action so an idle sleep ends early
+    TripleBuffer<RenderSnapshot> snapshots_;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "game.h"
+#include "registry.h"
+#include <cstdint>
+#include <vector>
+
+// Everything the renderer draws, copied out of a Game by the simulation thread
+// so the render thread never reads the live game. The field accessors mirror
+// FieldStore's, with each plot packed into one code.
+struct RenderSnapshot {
+    int width = 0;
+    int height = 0;
+    std::vector<uint16_t> plots; // 0 for empty, otherwise crop << 1 | ready
+    int blocks_wide = 0;
+    int blocks_high = 0;
+    std::vector<uint16_t> block_ready;
+    std::vector<uint16_t> block_growing;
+    Inventory inventory;
+    FlameId flame = 0;
+    bool refining = false;
+    double refine_seconds_left = 0.0; // At captured_ns
+    int64_t captured_ns = 0;          // Timing::now_ns() when taken
+    uint64_t revision = 0; // Game revision the field and inventory were copied at
+    uint64_t field_id = 0;      // FieldStore the plots follow
+    uint64_t field_version = 0; // Its version when they were last refreshed
+    int64_t tick = 0;      // Ticks run when this was taken
+    double tick_rate = 0.0; // Measured ticks per second
+
+    // Copies the game into this snapshot. Buffers are reused: only the field
+    // blocks changed since this snapshot's last capture are copied, and the
+    // inventory only when the game's revision has moved on.
+    void capture(const Game& game);
+    // The refining countdown carried forward in real time, so it keeps
+    // moving while the simulation sleeps between events.
+    double refine_seconds_left_at(int64_t now_ns) const;
+
+    size_t size() const { return plots.size(); }
+    bool is_empty(size_t i) const { return plots[i] == 0; }
+    bool is_ready(size_t i) const { return plots[i] & 1; }
+    ItemId get_crop(size_t i) const { return static_cast<ItemId>(plots[i] >> 1); }
+    int get_block_ready(size_t block) const { return block_ready[block]; }
+    int get_block_growing(size_t block) const { return block_growing[block]; }
+    int get_block_plots(size_t block) const;
+};
+
+#endif
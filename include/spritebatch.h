@@ -0,0 +1,81 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <SDL2/SDL.h>
+#include "registry.h"
+#include "sdlcolor.h"
+#include <string>
+#include <vector>
+
+// Sprites are cells of Constants::SPRITE_CELL pixels in one atlas, numbered
+// row-major: the fixed sprites first, then a growing and a ready cell per
+// crop in ItemId order.
+enum class Sprite : uint16_t {
+    PLOT_EMPTY,
+    BUTTON,
+    BUTTON_ACTIVE,
+    PANEL,
+    TILE_EMPTY,      // Level-of-detail tiles, coloured by the state most of their plots are in
+    TILE_GROWING,
+    TILE_READY,
+    FIRST_CROP
+};
+
+// Collects textured quads for a frame and submits them together: one
+// SDL_RenderGeometry call per flush however many sprites were added. Where
+// geometry is unsupported it falls back to one SDL_RenderFillRects per
+// sprite kind, filled with the cell's average colour. Sprites are drawn in
+// the order added (by kind, in order of first use, on the fallback).
+class SpriteBatch {
+public:
+    SpriteBatch();
+    ~SpriteBatch();
+    // Loads the atlas PNG; a missing or too small file gets a generated atlas of flat colours.
+    bool init(SDL_Renderer* renderer, const std::string& atlas_path) { return load(atlas_path) && upload(renderer); }
+    // init() in two steps: load() reads the atlas into a surface without a
+    // renderer; upload() makes the texture.
+    bool load(const std::string& atlas_path);
+    bool upload(SDL_Renderer* renderer);
+    void clear();
+    void add(Sprite sprite, const SDL_Rect& dst);
+    // Only the part of dst inside clip is drawn, with the sprite cropped to match.
+    void add(Sprite sprite, const SDL_Rect& dst, const SDL_Rect& clip);
+    void flush();
+    size_t get_last_sprites() const { return last_sprites_; }
+    int get_last_draw_calls() const { return last_draw_calls_; }
+
+    static Sprite crop_sprite(ItemId crop, bool ready) {
+        return static_cast<Sprite>(static_cast<int>(Sprite::FIRST_CROP) + (crop - 1) * 2 + (ready ? 1 : 0));
+    }
+    static size_t sprite_count() { return static_cast<size_t>(Sprite::FIRST_CROP) + (Registry::get().item_count() - 1) * 2; }
+
+private:
+    struct Quad {
+        Sprite sprite;
+        SDL_Rect dst;
+        float u0, v0, u1, v1; // Part of the cell drawn, as fractions of it
+    };
+
+    SDL_Surface* generate_atlas() const;
+    void flush_rects();
+
+    SDL_Renderer* renderer_;
+    SDL_Surface* sheet_; // Loaded atlas waiting for upload()
+    SDL_Texture* atlas_;
+    std::vector<SDL_Rect> cells_;      // Source rect per sprite
+    std::vector<SDL_Color> average_;   // Fill colour per sprite for the rect fallback
+    std::vector<Quad> quads_;          // Queued since the last flush
+    bool geometry_;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    int atlas_width_;
+    int atlas_height_;
+    std::vector<SDL_Vertex> vertices_;
+    std::vector<int> indices_;         // Two triangles per quad; only ever grows
+#endif
+    std::vector<std::vector<SDL_Rect>> fallback_rects_; // Per sprite kind
+    std::vector<Sprite> order_;
+    size_t last_sprites_;
+    int last_draw_calls_;
+};
+
+#endif
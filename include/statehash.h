@@ -0,0 +1,38 @@
+#ifndef STATEHASH_H
+#define STATEHASH_H
+
+#include <cstdint>
+#include <string_view>
+
+// Keys for the incremental game state hash. It is Zobrist-style: the hash is
+// the XOR of one key per piece of state, so a change XORs the old key out and
+// the new one in. Keys are mixed from the piece's value rather than read from
+// a table, since a table for every plot, crop and ready time would outgrow
+// the farm. Empty plots and zero counts key to 0, so a new farm needs no
+// pass over its plots to start its hash.
+namespace StateHash {
+    // splitmix64's finalizer: a bijection with full avalanche.
+    constexpr uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    // Kinds of state, so equal values in different places get unrelated keys.
+    enum Kind : uint64_t { PLOT = 1, ITEM, PROFICIENCY, FLAME, REFINING, NAME };
+
+    constexpr uint64_t key(Kind kind, uint64_t a, uint64_t b = 0) {
+        return mix(mix(mix(kind) ^ a) ^ b);
+    }
+
+    // Keys item and flame names rather than ids, so hashes survive registry reordering.
+    constexpr uint64_t name_key(std::string_view name) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (char c : name) hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+        return key(NAME, hash);
+    }
+}
+
+#endif
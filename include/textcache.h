@@ -0,0 +1,60 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "constants.h"
+#include "sdlcolor.h"
+#include <array>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Keeps rasterized text on the GPU so steady-state frames make no TTF calls and
+// allocate no textures. Whole strings are cached per key and only re-rendered
+// when the text under that key changes; the glyph atlas draws arbitrary ASCII
+// (counters, stats) without rasterizing anything. Keys and text are looked up
+// as views, so a frame that hits the cache allocates nothing.
+class TextCache {
+public:
+    TextCache();
+    ~TextCache();
+    bool init(SDL_Renderer* renderer, TTF_Font* font) { return rasterize(font) && upload(renderer); }
+    // init() in two steps: rasterize() draws the glyph atlas into a surface
+    // without a renderer; upload() then turns it into a texture.
+    bool rasterize(TTF_Font* font);
+    bool upload(SDL_Renderer* renderer);
+    void clear();
+    void draw(std::string_view key, std::string_view text, const SDL_Rect& dst);
+    void draw_glyphs(std::string_view text, int x, int y, const Constants::Color& color = Constants::WHITE);
+    int glyph_height() const { return line_height_; }
+
+private:
+    static constexpr char FIRST_GLYPH = ' ';
+    static constexpr char LAST_GLYPH = '~';
+    static constexpr int ATLAS_COLUMNS = 16;
+
+    struct Entry {
+        std::string text;
+        SDL_Texture* texture;
+    };
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+    };
+    struct Glyph {
+        SDL_Rect src;
+        int advance;
+    };
+
+    SDL_Renderer* renderer_;
+    TTF_Font* font_;
+    SDL_Surface* sheet_; // Rasterized atlas waiting for upload()
+    SDL_Texture* atlas_;
+    std::array<Glyph, LAST_GLYPH - FIRST_GLYPH + 1> glyphs_;
+    int line_height_;
+    std::unordered_map<std::string, Entry, KeyHash, std::equal_to<>> entries_;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers for data-parallel loops. parallel_for splits [0, count)
+// into contiguous chunks and deals them out in blocks, one per worker queue, so
+// a worker keeps touching the same memory from call to call. A worker that runs
+// dry steals from the back of another queue. The calling thread works as
+// worker 0 and the call returns only once every chunk has finished.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // fn(begin, end) is called once per chunk and must not throw.
+    void parallel_for(size_t count, size_t chunk, const std::function<void(size_t, size_t)>& fn);
+    size_t size() const { return queues_.size(); }
+    uint64_t get_steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+    // Padded so neighbouring queue locks do not share a cache line.
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    void worker_loop(size_t index);
+    bool run_one(size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    uint64_t generation_;
+    bool stopping_;
+    const std::function<void(size_t, size_t)>* job_;
+    std::atomic<size_t> pending_;
+    std::atomic<uint64_t> steals_;
+};
+
+#endif
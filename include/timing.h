@@ -0,0 +1,66 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include "constants.h"
+#include <cstdint>
+
+namespace Timing {
+    // Monotonic high-resolution time in nanoseconds.
+    int64_t now_ns();
+    // Wall-clock milliseconds since the Unix epoch, for timestamps that outlive the process.
+    int64_t unix_ms();
+}
+
+// Accumulates real elapsed time and hands out a whole number of fixed-length
+// simulation ticks. Time beyond max_ticks per call is dropped so a slow frame
+// cannot snowball into ever more catch-up work (spiral of death).
+class FixedTimestep {
+public:
+    explicit FixedTimestep(double tick_rate = Constants::TICK_RATE, int max_ticks = Constants::MAX_TICKS_PER_FRAME);
+    int advance(int64_t elapsed_ns);
+    // Every whole tick in elapsed_ns, with no catch-up limit: for time the
+    // caller slept through on purpose and still has to simulate.
+    int64_t advance_all(int64_t elapsed_ns);
+    double get_dt() const { return static_cast<double>(step_ns_) / Constants::NANOSECONDS_PER_SECOND; }
+    int64_t get_step_ns() const { return step_ns_; }
+    int64_t get_dropped_ns() const { return dropped_ns_; }
+    int64_t get_pending_ns() const { return accumulator_ns_; } // Time carried into the next tick
+
+private:
+    int64_t step_ns_;
+    int max_ticks_;
+    int64_t accumulator_ns_;
+    int64_t dropped_ns_;
+};
+
+// Paces frames against absolute deadlines. Sleeps end early by the measured
+// average oversleep and the remainder is spun, so the limiter corrects for the
+// scheduler's wake-up latency instead of drifting.
+class FrameLimiter {
+public:
+    explicit FrameLimiter(double target_fps = Constants::TARGET_FPS);
+    void wait();
+    double get_overshoot_ms() const { return overshoot_ns_ / 1e6; }
+
+private:
+    int64_t frame_ns_;
+    int64_t next_deadline_ns_;
+    double sleep_error_ns_; // Average amount sleep_for overshoots its request
+    double overshoot_ns_;   // Average lateness relative to the frame deadline
+};
+
+// Counts events and reports their rate over the last completed window.
+class RateCounter {
+public:
+    explicit RateCounter(double window_seconds = 1.0);
+    void add(int64_t now_ns, int64_t count = 1);
+    double get_rate() const { return rate_; }
+
+private:
+    int64_t window_ns_;
+    int64_t window_start_ns_;
+    int64_t count_;
+    double rate_;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Hands whole values from one writer thread to one reader thread without
+// locks or copies. The writer fills back() and publishes it; the reader takes
+// the newest published value with update() and reads front() for as long as
+// it likes. Each side owns one buffer and the third sits between them, so
+// neither ever waits for the other and the reader skips values it was too
+// slow to see.
+template <typename T>
+class TripleBuffer {
+public:
+    T& back() { return buffers_[back_]; }
+    void publish() { back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    // True when a newer value was taken.
+    bool update() {
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH)) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& front() const { return buffers_[front_]; }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4; // Set while the middle buffer is unread
+
+    T buffers_[3];
+    uint8_t front_ = 0;
+    alignas(64) std::atomic<uint8_t> middle_{1};
+    alignas(64) uint8_t back_ = 2;
+};
+
+#endif
@@ -0,0 +1,301 @@
+// Microbenchmarks for the game's hot paths. Prints a summary table to stderr
+// and the full results as JSON to stdout (or --out FILE) for diffing.
+#include "bench.h"
+#include "alloccount.h"
+#include "game.h"
+#include "savemanager.h"
+#include "snapshot.h"
+#include "triplebuffer.h"
+#include "log.h"
+#include "timing.h"
+#include "constants.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using json = nlohmann::json;
+
+BenchState::BenchState(int64_t iterations)
+    : iterations_(iterations), remaining_(iterations), start_ns_(0), elapsed_ns_(0), start_allocations_(0), allocations_(0), items_(0),
+      bytes_(0), started_(false) {}
+
+bool BenchState::keep_running() {
+    if (!started_) {
+        started_ = true;
+        resume_timing();
+    }
+    if (remaining_-- > 0) return true;
+    pause_timing();
+    return false;
+}
+
+void BenchState::pause_timing() {
+    elapsed_ns_ += Timing::now_ns() - start_ns_;
+    allocations_ += static_cast<int64_t>(AllocCount::allocations() - start_allocations_);
+}
+
+void BenchState::resume_timing() {
+    start_allocations_ = AllocCount::allocations();
+    start_ns_ = Timing::now_ns();
+}
+
+void BenchSuite::add(const std::string& name, std::function<void(BenchState&)> body) {
+    benchmarks_.push_back(Benchmark{name, std::move(body)});
+}
+
+json BenchSuite::run(const BenchOptions& options) const {
+    json results = json::array();
+    const int64_t min_ns = static_cast<int64_t>(options.min_time * Constants::NANOSECONDS_PER_SECOND);
+    for (const Benchmark& benchmark : benchmarks_) {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) continue;
+
+        // Grow the iteration count until one run covers min_time.
+        int64_t iterations = 1;
+        while (true) {
+            BenchState state(iterations);
+            benchmark.body(state);
+            if (state.get_elapsed_ns() >= min_ns || iterations >= (int64_t{1} << 40)) break;
+            double scale = state.get_elapsed_ns() > 0 ? 1.4 * min_ns / state.get_elapsed_ns() : 100.0;
+            iterations = std::max(iterations + 1, static_cast<int64_t>(iterations * std::clamp(scale, 2.0, 100.0)));
+        }
+
+        std::vector<double> ns_per_iteration;
+        double items_per_second = 0.0, bytes_per_second = 0.0, allocations = 0.0;
+        for (int r = 0; r < std::max(1, options.repetitions); ++r) {
+            BenchState state(iterations);
+            benchmark.body(state);
+            double seconds = state.get_elapsed_ns() / Constants::NANOSECONDS_PER_SECOND;
+            ns_per_iteration.push_back(static_cast<double>(state.get_elapsed_ns()) / iterations);
+            allocations += static_cast<double>(state.get_allocations()) / iterations;
+            if (seconds > 0) {
+                items_per_second += state.get_items_processed() / seconds;
+                bytes_per_second += state.get_bytes_processed() / seconds;
+            }
+        }
+        size_t runs = ns_per_iteration.size();
+        std::vector<double> sorted = ns_per_iteration;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0.0;
+        for (double ns : sorted) mean += ns / runs;
+        double variance = 0.0;
+        for (double ns : sorted) variance += (ns - mean) * (ns - mean) / runs;
+
+        json result = {{"name", benchmark.name}, {"iterations", iterations}, {"repetitions", runs},
+                       {"ns_per_iteration", {{"mean", mean}, {"median", sorted[runs / 2]}, {"min", sorted.front()},
+                                             {"max", sorted.back()}, {"stddev", std::sqrt(variance)}}},
+                       {"allocations_per_iteration", allocations / runs}};
+        if (items_per_second > 0) result["items_per_second"] = items_per_second / runs;
+        if (bytes_per_second > 0) result["bytes_per_second"] = bytes_per_second / runs;
+        std::fprintf(stderr, "%-32s %14.1f ns %12lld iterations %10.1f allocs\n", benchmark.name.c_str(), sorted[runs / 2],
+                     static_cast<long long>(iterations), allocations / runs);
+        results.push_back(result);
+    }
+    return results;
+}
+
+namespace {
+
+constexpr double TICK_DT = 1.0 / Constants::TICK_RATE;
+
+// A fully planted farm whose plots mature evenly across one growth period,
+// the steady state of a farm that is replanted as soon as it ripens.
+Game make_planted_farm(int width, int height) {
+    Game game(width, height, 1);
+    const Registry& registry = Registry::get();
+    const int64_t period = static_cast<int64_t>(Constants::DEFAULT_GROWTH_TIME * Constants::TICK_RATE);
+    for (int i = 0; i < width * height; ++i) {
+        game.restore_field(i, registry.fire_grass, to_game_time(TICK_DT * (i % period + 1)), false);
+    }
+    return game;
+}
+
+void replant_ready(Game& game) {
+    const FieldStore& fields = game.get_fields();
+    ItemId harvested;
+    for (size_t i = fields.next_ready(0); i != FieldStore::NPOS; i = fields.next_ready(i + 1)) {
+        game.harvest(static_cast<int>(i), harvested);
+        game.plant(static_cast<int>(i), harvested);
+    }
+}
+
+void add_update_benchmark(BenchSuite& suite, int width, int height) {
+    suite.add("game_update/" + std::to_string(width * height), [width, height](BenchState& state) {
+        Game game = make_planted_farm(width, height);
+        uint64_t revision = game.get_revision();
+        while (state.keep_running()) {
+            game.update(TICK_DT);
+            // Replant whatever matured, outside the measurement, to stay at steady state.
+            if (game.get_revision() != revision) {
+                state.pause_timing();
+                replant_ready(game);
+                revision = game.get_revision();
+                state.resume_timing();
+            }
+        }
+        state.set_items_processed(state.get_iterations() * width * height);
+    });
+}
+
+void add_refine_benchmark(BenchSuite& suite) {
+    suite.add("game_refine", [](BenchState& state) {
+        Game game(Constants::GRID_SIZE, Constants::GRID_SIZE, 1);
+        const RecipeDef& recipe = Registry::get().recipes().front();
+        game.restore_item_count(recipe.input, 1 << 30);
+        while (state.keep_running()) {
+            game.start_refining();
+            game.update(recipe.refine_time); // Fires REFINE_DONE, which rolls and pays out
+        }
+        state.set_items_processed(state.get_iterations());
+    });
+}
+
+void add_field_benchmark(BenchSuite& suite, int width, int height) {
+    suite.add("field_scan_ready/" + std::to_string(width * height), [width, height](BenchState& state) {
+        Game game = make_planted_farm(width, height);
+        for (int i = 0; i < Constants::TICK_RATE * Constants::DEFAULT_GROWTH_TIME / 2; ++i) game.update(TICK_DT);
+        const FieldStore& fields = game.get_fields();
+        size_t visited = 0;
+        while (state.keep_running()) {
+            for (size_t i = fields.next_ready(0); i != FieldStore::NPOS; i = fields.next_ready(i + 1)) ++visited;
+        }
+        if (visited == 0) std::fprintf(stderr, "field_scan_ready found no ready plots\n");
+        state.set_items_processed(state.get_iterations() * width * height);
+    });
+}
+
+void add_save_benchmarks(BenchSuite& suite, const std::string& label, int width, int height, const std::string& suffix = ".json") {
+    const std::string path = (std::filesystem::temp_directory_path() / ("alchemist_bench_" + label + suffix)).string();
+    suite.add("save/" + label, [=](BenchState& state) {
+        Game game = make_planted_farm(width, height);
+        while (state.keep_running()) {
+            if (!SaveManager::save(game, path)) {
+                std::fprintf(stderr, "save/%s cannot write %s\n", label.c_str(), path.c_str());
+                while (state.keep_running()) {}
+                return;
+            }
+        }
+        state.set_bytes_processed(state.get_iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+    });
+    suite.add("load/" + label, [=](BenchState& state) {
+        if (!SaveManager::save(make_planted_farm(width, height), path)) {
+            std::fprintf(stderr, "load/%s cannot write %s\n", label.c_str(), path.c_str());
+            while (state.keep_running()) {}
+            return;
+        }
+        Game game;
+        while (state.keep_running()) SaveManager::load(game, path);
+        state.set_bytes_processed(state.get_iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+        std::filesystem::remove(path);
+    });
+}
+
+// Serialization alone, into a reused buffer: steady state should not allocate.
+void add_codec_benchmarks(BenchSuite& suite, const std::string& label, int width, int height) {
+    suite.add("save_encode/" + label, [=](BenchState& state) {
+        Game game = make_planted_farm(width, height);
+        std::string buffer;
+        while (state.keep_running()) SaveManager::serialize(game, 0, buffer);
+        state.set_bytes_processed(state.get_iterations() * static_cast<int64_t>(buffer.size()));
+    });
+    suite.add("save_decode/" + label, [=](BenchState& state) {
+        const std::string data = SaveManager::serialize(make_planted_farm(width, height));
+        Game game;
+        while (state.keep_running()) SaveManager::deserialize(data, game);
+        state.set_bytes_processed(state.get_iterations() * static_cast<int64_t>(data.size()));
+    });
+}
+
+// Per-tick publishing cost on the simulation thread: a capture into the back
+// buffer after every tick, most of which change the field.
+void add_snapshot_benchmark(BenchSuite& suite, int width, int height) {
+    suite.add("snapshot_publish/" + std::to_string(width * height), [width, height](BenchState& state) {
+        Game game = make_planted_farm(width, height);
+        TripleBuffer<RenderSnapshot> snapshots;
+        while (state.keep_running()) {
+            state.pause_timing();
+            game.update(TICK_DT);
+            replant_ready(game);
+            state.resume_timing();
+            snapshots.back().capture(game);
+            snapshots.publish();
+        }
+        state.set_items_processed(state.get_iterations() * width * height);
+    });
+}
+
+// Full state hash recompute, the fallback the incremental hash saves callers
+// (compare with save_encode for the serialize-and-compare it replaces).
+void add_state_hash_benchmark(BenchSuite& suite, int width, int height) {
+    suite.add("state_hash_recompute/" + std::to_string(width * height), [width, height](BenchState& state) {
+        Game game = make_planted_farm(width, height);
+        volatile uint64_t sink = 0;
+        while (state.keep_running()) sink = game.compute_state_hash();
+        (void)sink;
+        state.set_items_processed(state.get_iterations() * width * height);
+    });
+}
+
+void print_usage() {
+    std::cout << "Usage: alchemist_bench [options]\n"
+              << "  --filter TEXT        run only benchmarks whose name contains TEXT\n"
+              << "  --min-time S         seconds per repetition (default 0.5)\n"
+              << "  --repetitions N      measured runs per benchmark (default 3)\n"
+              << "  --out FILE           write JSON results to FILE instead of stdout\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    std::string out_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) options.filter = argv[++i];
+        else if (arg == "--min-time" && has_value) options.min_time = std::atof(argv[++i]);
+        else if (arg == "--repetitions" && has_value) options.repetitions = std::atoi(argv[++i]);
+        else if (arg == "--out" && has_value) out_path = argv[++i];
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    BenchSuite suite;
+    add_update_benchmark(suite, 4, 4);
+    add_update_benchmark(suite, 1024, 1024);
+    add_refine_benchmark(suite);
+    add_field_benchmark(suite, 1024, 1024);
+    add_save_benchmarks(suite, "small", 4, 4);
+    add_save_benchmarks(suite, "large", 256, 256);
+    add_save_benchmarks(suite, "large_binary", 256, 256, Constants::BINARY_SAVE_SUFFIX);
+    add_codec_benchmarks(suite, "large", 256, 256);
+    add_snapshot_benchmark(suite, 1024, 1024);
+    add_state_hash_benchmark(suite, 1024, 1024);
+#ifdef ALCHEMIST_BENCH_RENDERER
+    add_renderer_benchmarks(suite);
+#endif
+
+    json report = {{"context", {{"log_level", ALCHEMIST_LOG_LEVEL},
+                                {"hardware_threads", std::thread::hardware_concurrency()},
+                                {"min_time", options.min_time},
+                                {"repetitions", options.repetitions}}},
+                   {"benchmarks", suite.run(options)}};
+    if (out_path.empty()) {
+        std::cout << report.dump(Constants::JSON_INDENT) << std::endl;
+    } else {
+        std::ofstream file(out_path);
+        file << report.dump(Constants::JSON_INDENT) << std::endl;
+        if (!file) {
+            std::cerr << "Cannot write " << out_path << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+// Renderer benchmarks. They run on SDL's dummy video driver with the software
+// renderer, so they need no display or GPU.
+#include "bench.h"
+#include "renderer.h"
+#include <cstdio>
+#include <memory>
+
+namespace {
+
+// One renderer for all renderer benchmarks; SDL is torn down at exit.
+Renderer* shared_renderer() {
+    static std::unique_ptr<Renderer> renderer = [] {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+        auto created = std::make_unique<Renderer>();
+        if (!created->init(false, true)) {
+            std::fprintf(stderr, "Renderer init failed, renderer benchmarks skipped\n");
+            created.reset();
+        }
+        return created;
+    }();
+    return renderer.get();
+}
+
+}
+
+void add_renderer_benchmarks(BenchSuite& suite) {
+    const struct {
+        const char* name;
+        Screen screen;
+    } screens[] = {{"render/field", Screen::FIELD}, {"render/inventory", Screen::INVENTORY}, {"render/refining", Screen::REFINING}};
+    for (const auto& entry : screens) {
+        Screen screen = entry.screen;
+        suite.add(entry.name, [screen](BenchState& state) {
+            Renderer* renderer = shared_renderer();
+            if (!renderer) {
+                while (state.keep_running()) {}
+                return;
+            }
+            Game game(Constants::GRID_SIZE, Constants::GRID_SIZE, 1);
+            for (size_t i = 0; i < game.get_fields().size(); i += 2) game.plant(static_cast<int>(i), Registry::get().fire_grass);
+            RenderSnapshot snapshot;
+            snapshot.capture(game);
+            renderer->set_loop_stats(Constants::TARGET_FPS, Constants::TICK_RATE);
+            while (state.keep_running()) renderer->render(snapshot, screen);
+            state.set_items_processed(state.get_iterations());
+        });
+    }
+}
@@ -0,0 +1,314 @@
+#include "binarysave.h"
+#include "log.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace BinarySave {
+
+namespace {
+    constexpr size_t align8(size_t n) {
+        return (n + 7) & ~size_t(7);
+    }
+
+    // Sections and strides the current version writes.
+    struct Layout {
+        Section state, fields, inventory, names;
+        size_t file_bytes;
+    };
+
+    Layout plan(size_t fields, size_t inventory, size_t names, size_t chars) {
+        Layout layout;
+        size_t offset = sizeof(Header);
+        layout.state = Section{offset, 1, sizeof(StateRecord)};
+        offset = align8(offset + sizeof(StateRecord));
+        layout.fields = Section{offset, static_cast<uint32_t>(fields), sizeof(FieldRecord)};
+        offset = align8(offset + fields * sizeof(FieldRecord));
+        layout.inventory = Section{offset, static_cast<uint32_t>(inventory), sizeof(InventoryRecord)};
+        offset = align8(offset + inventory * sizeof(InventoryRecord));
+        layout.names = Section{offset, static_cast<uint32_t>(names), 0};
+        layout.file_bytes = align8(offset + names * sizeof(NameRecord) + chars);
+        return layout;
+    }
+
+    void write_header(uint8_t* data, const Layout& layout, uint32_t version) {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = version;
+        header.header_bytes = sizeof(Header);
+        header.file_bytes = layout.file_bytes;
+        header.state = layout.state;
+        header.fields = layout.fields;
+        header.inventory = layout.inventory;
+        header.names = layout.names;
+        header.checksum = checksum(data + sizeof(Header), layout.file_bytes - sizeof(Header));
+        std::memcpy(data, &header, sizeof(header));
+    }
+
+    bool fits(const Section& section, size_t record_bytes, size_t size) {
+        if (section.offset % 8 != 0 || section.offset < sizeof(Header) || section.offset > size) return false;
+        if (record_bytes == 0) return true; // String table: its entries are checked one by one
+        return section.stride >= record_bytes && section.count <= (size - section.offset) / section.stride;
+    }
+
+    // Header checks shared by View::open and migrate(); record strides are checked by the caller.
+    bool check_header(const uint8_t* data, size_t size, std::string& error) {
+        if (!is_binary(data, size) || size < sizeof(Header)) {
+            error = "not a binary save";
+            return false;
+        }
+        const Header& header = *reinterpret_cast<const Header*>(data);
+        if (header.version > VERSION) {
+            error = "save version " + std::to_string(header.version) + " is newer than this build";
+            return false;
+        }
+        if (header.header_bytes != sizeof(Header) || header.file_bytes != size || size % 8 != 0) {
+            error = "truncated or resized file";
+            return false;
+        }
+        if (header.checksum != checksum(data + sizeof(Header), size - sizeof(Header))) {
+            error = "checksum mismatch";
+            return false;
+        }
+        return true;
+    }
+
+    void copy_section(const uint8_t* from, const Section& old_section, uint8_t* to, const Section& new_section) {
+        size_t bytes = std::min(old_section.stride, new_section.stride);
+        for (size_t i = 0; i < old_section.count; ++i) {
+            std::memcpy(to + new_section.offset + i * new_section.stride, from + old_section.offset + i * old_section.stride, bytes);
+        }
+    }
+}
+
+uint64_t checksum(const uint8_t* data, size_t size) {
+    // FNV-1a a word at a time; files are padded to whole words.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    for (; i < size; ++i) hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+bool is_binary(const uint8_t* data, size_t size) {
+    return size >= sizeof(MAGIC) && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+std::string encode(const Game& game, int64_t saved_at_ms) {
+    std::string out;
+    encode(game, saved_at_ms, out);
+    return out;
+}
+
+void encode(const Game& game, int64_t saved_at_ms, std::string& out) {
+    const Registry& registry = Registry::get();
+    const FieldStore& fields = game.get_fields();
+    // Item names sit at their id and flames follow, so ids double as name indices.
+    const size_t name_count = registry.item_count() + registry.flame_count();
+    auto name_at = [&registry](size_t i) -> std::string_view {
+        return i < registry.item_count() ? registry.item_name(static_cast<ItemId>(i)) : registry.flame(static_cast<FlameId>(i - registry.item_count())).name;
+    };
+    size_t chars = 0;
+    for (size_t i = 0; i < name_count; ++i) chars += name_at(i).size();
+
+    size_t inventory = registry.item_count() - 1; // Every item but EMPTY_ITEM
+    Layout layout = plan(fields.size(), inventory, name_count, chars);
+    out.assign(layout.file_bytes, '\0');
+    uint8_t* data = reinterpret_cast<uint8_t*>(out.data());
+
+    StateRecord state{};
+    state.time = game.get_time();
+    state.saved_at = saved_at_ms;
+    state.refine_done_at = game.is_refining() ? game.get_refine_done_at() : 0;
+    state.seed = game.get_rng().get_seed();
+    std::copy(game.get_rng().get_state().begin(), game.get_rng().get_state().end(), state.rng_state);
+    state.width = fields.get_width();
+    state.height = fields.get_height();
+    state.proficiency = game.get_proficiency();
+    state.refine_recipe = game.is_refining() ? static_cast<uint32_t>(game.get_refine_recipe()) : 0;
+    state.flame = static_cast<uint16_t>(registry.item_count() + game.get_flame_type());
+    state.refining = game.is_refining();
+    state.state_hash = game.get_state_hash();
+    std::memcpy(data + layout.state.offset, &state, sizeof(state));
+
+    for (size_t i = 0; i < fields.size(); ++i) {
+        FieldRecord record{};
+        record.ready_at = fields.get_ready_at(i);
+        record.crop = fields.get_crop(i);
+        record.flags = fields.is_ready(i) ? FIELD_READY : 0;
+        std::memcpy(data + layout.fields.offset + i * sizeof(record), &record, sizeof(record));
+    }
+    for (size_t i = 0; i < inventory; ++i) {
+        InventoryRecord record{};
+        record.item = static_cast<uint16_t>(i + 1);
+        record.count = game.get_inventory().get(record.item);
+        std::memcpy(data + layout.inventory.offset + i * sizeof(record), &record, sizeof(record));
+    }
+    size_t char_offset = name_count * sizeof(NameRecord);
+    for (size_t i = 0; i < name_count; ++i) {
+        std::string_view name = name_at(i);
+        NameRecord record{static_cast<uint32_t>(char_offset), static_cast<uint32_t>(name.size())};
+        std::memcpy(data + layout.names.offset + i * sizeof(record), &record, sizeof(record));
+        std::memcpy(data + layout.names.offset + char_offset, name.data(), name.size());
+        char_offset += name.size();
+    }
+    write_header(data, layout, VERSION);
+}
+
+bool needs_migration(const uint8_t* data, size_t size) {
+    if (size < sizeof(Header) || !is_binary(data, size)) return false;
+    const Header& header = *reinterpret_cast<const Header*>(data);
+    return header.version < VERSION || header.state.stride < sizeof(StateRecord) || header.fields.stride < sizeof(FieldRecord) ||
+           header.inventory.stride < sizeof(InventoryRecord);
+}
+
+bool migrate(std::vector<uint8_t>& buffer, std::string& error) {
+    if (!check_header(buffer.data(), buffer.size(), error)) return false;
+    if (!needs_migration(buffer.data(), buffer.size())) return true;
+    const Header old = *reinterpret_cast<const Header*>(buffer.data());
+    // Version 1 is the first format; explicit steps for later versions go here,
+    // each rewriting the buffer one version forward before the widening below.
+    if (!fits(old.state, 1, buffer.size()) || old.state.count != 1 || !fits(old.fields, 1, buffer.size()) ||
+        !fits(old.inventory, 1, buffer.size()) || !fits(old.names, 0, buffer.size())) {
+        error = "section out of bounds";
+        return false;
+    }
+    size_t name_bytes = buffer.size() - old.names.offset;
+    Layout layout = plan(old.fields.count, old.inventory.count, 0, name_bytes);
+    layout.names.count = old.names.count;
+    std::vector<uint8_t> upgraded(layout.file_bytes, 0);
+    copy_section(buffer.data(), old.state, upgraded.data(), layout.state);
+    copy_section(buffer.data(), old.fields, upgraded.data(), layout.fields);
+    copy_section(buffer.data(), old.inventory, upgraded.data(), layout.inventory);
+    // Name offsets are relative to the section, so the table moves as one block.
+    std::memcpy(upgraded.data() + layout.names.offset, buffer.data() + old.names.offset, name_bytes);
+    write_header(upgraded.data(), layout, VERSION);
+    LOG_INFO("Migrated binary save", {"from_version", static_cast<int>(old.version)}, {"to_version", static_cast<int>(VERSION)});
+    buffer = std::move(upgraded);
+    return true;
+}
+
+bool View::open(const uint8_t* data, size_t size, std::string& error) {
+    data_ = nullptr;
+    size_ = 0;
+    if (!check_header(data, size, error)) return false;
+    if (needs_migration(data, size)) {
+        error = "older layout, migrate first";
+        return false;
+    }
+    const Header& header = *reinterpret_cast<const Header*>(data);
+    if (!fits(header.state, sizeof(StateRecord), size) || header.state.count != 1 || !fits(header.fields, sizeof(FieldRecord), size) ||
+        !fits(header.inventory, sizeof(InventoryRecord), size) || !fits(header.names, 0, size) ||
+        header.names.count > (size - header.names.offset) / sizeof(NameRecord)) {
+        error = "section out of bounds";
+        return false;
+    }
+    const StateRecord& state = *reinterpret_cast<const StateRecord*>(data + header.state.offset);
+    if (state.width <= 0 || state.height <= 0 || state.width > Constants::MAX_FARM_SIDE || state.height > Constants::MAX_FARM_SIDE) {
+        error = "unsupported farm size";
+        return false;
+    }
+    if (static_cast<uint64_t>(state.width) * state.height != header.fields.count) {
+        error = "field count does not match the grid size";
+        return false;
+    }
+    size_t names_bytes = size - header.names.offset;
+    for (size_t i = 0; i < header.names.count; ++i) {
+        NameRecord name;
+        std::memcpy(&name, data + header.names.offset + i * sizeof(NameRecord), sizeof(name));
+        if (name.offset > names_bytes || name.length > names_bytes - name.offset) {
+            error = "name out of bounds";
+            return false;
+        }
+    }
+    data_ = data;
+    size_ = size;
+    return true;
+}
+
+std::string_view View::name(size_t i) const {
+    if (i >= name_count()) return {};
+    const NameRecord& record = *reinterpret_cast<const NameRecord*>(data_ + header().names.offset + i * sizeof(NameRecord));
+    return std::string_view(reinterpret_cast<const char*>(data_ + header().names.offset + record.offset), record.length);
+}
+
+void View::apply(Game& game) const {
+    const Registry& registry = Registry::get();
+    const StateRecord& saved = state();
+    // Each name is looked up once, not once per record.
+    std::vector<ItemId> items(name_count());
+    for (size_t i = 0; i < items.size(); ++i) items[i] = registry.find_item(name(i));
+    auto item_at = [&items](uint16_t index) { return index < items.size() ? items[index] : Registry::INVALID_ITEM; };
+
+    game = Game(saved.width, saved.height, saved.seed);
+    Rng::State rng;
+    std::copy(std::begin(saved.rng_state), std::end(saved.rng_state), rng.begin());
+    game.set_rng_state(saved.seed, rng);
+    game.set_time(saved.time);
+    for (size_t i = 0; i < field_count(); ++i) {
+        const FieldRecord& f = field(i);
+        ItemId crop = item_at(f.crop);
+        if (crop == Registry::INVALID_ITEM) {
+            LOG_WARN("Unknown crop in save, field left empty", {"type", std::string(name(f.crop))}, {"field", i});
+            continue;
+        }
+        game.restore_field(static_cast<int>(i), crop, f.ready_at, f.flags & FIELD_READY);
+    }
+    for (size_t i = 0; i < inventory_count(); ++i) {
+        const InventoryRecord& record = inventory(i);
+        ItemId item = item_at(record.item);
+        if (item == Registry::INVALID_ITEM || item == Registry::EMPTY_ITEM) {
+            LOG_WARN("Unknown item in save ignored", {"item", std::string(name(record.item))});
+            continue;
+        }
+        game.restore_item_count(item, record.count);
+    }
+    if (saved.refining) game.restore_refining(saved.refine_recipe, saved.refine_done_at);
+    game.set_proficiency(saved.proficiency);
+    FlameId flame = registry.find_flame(name(saved.flame));
+    game.set_flame_type(flame != Registry::INVALID_FLAME ? flame : registry.low_flame);
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (data_ && fallback_.empty()) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+}
+
+bool MappedFile::open(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (mapped != MAP_FAILED) {
+        data_ = static_cast<const uint8_t*>(mapped);
+        size_ = static_cast<size_t>(st.st_size);
+        return true;
+    }
+#endif
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    fallback_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (fallback_.empty()) return false;
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+    return true;
+}
+
+}
@@ -0,0 +1,75 @@
+#include "camera.h"
+#include <algorithm>
+#include <cmath>
+
+Camera::Camera()
+    : viewport_{Constants::FIELD_START_X, Constants::FIELD_START_Y, Constants::FIELD_GRID_WIDTH, Constants::FIELD_GRID_HEIGHT},
+      origin_x_(0.0), origin_y_(0.0), zoom_(1.0) {}
+
+void Camera::reset() {
+    origin_x_ = 0.0;
+    origin_y_ = 0.0;
+    zoom_ = 1.0;
+}
+
+void Camera::pan(double dx, double dy) {
+    origin_x_ -= dx / zoom_;
+    origin_y_ -= dy / zoom_;
+}
+
+void Camera::zoom_at(double factor, int x, int y) {
+    double world_x = origin_x_ + (x - viewport_.x) / zoom_;
+    double world_y = origin_y_ + (y - viewport_.y) / zoom_;
+    zoom_ = std::clamp(zoom_ * factor, Constants::CAMERA_MIN_ZOOM, Constants::CAMERA_MAX_ZOOM);
+    origin_x_ = world_x - (x - viewport_.x) / zoom_;
+    origin_y_ = world_y - (y - viewport_.y) / zoom_;
+}
+
+void Camera::clamp(int width, int height) {
+    double world_w = static_cast<double>(width) * Constants::FIELD_SPACING;
+    double world_h = static_cast<double>(height) * Constants::FIELD_SPACING;
+    double fit = std::min(viewport_.w / world_w, viewport_.h / world_h);
+    zoom_ = std::clamp(zoom_, std::max(Constants::CAMERA_MIN_ZOOM, std::min(1.0, fit / 2)), Constants::CAMERA_MAX_ZOOM);
+    double view_w = viewport_.w / zoom_, view_h = viewport_.h / zoom_;
+    origin_x_ = std::clamp(origin_x_, -view_w / 2, std::max(-view_w / 2, world_w - view_w / 2));
+    origin_y_ = std::clamp(origin_y_, -view_h / 2, std::max(-view_h / 2, world_h - view_h / 2));
+}
+
+size_t Camera::plot_at(int x, int y, int width, int height) const {
+    if (x < viewport_.x || x >= viewport_.x + viewport_.w || y < viewport_.y || y >= viewport_.y + viewport_.h) return NPOS;
+    double world_x = origin_x_ + (x - viewport_.x) / zoom_;
+    double world_y = origin_y_ + (y - viewport_.y) / zoom_;
+    double col = std::floor(world_x / Constants::FIELD_SPACING), row = std::floor(world_y / Constants::FIELD_SPACING);
+    if (col < 0 || row < 0 || col >= width || row >= height) return NPOS;
+    return static_cast<size_t>(row) * width + static_cast<size_t>(col);
+}
+
+Camera::Range Camera::visible(int width, int height, int block) const {
+    double cell = static_cast<double>(Constants::FIELD_SPACING) * block;
+    int cols = (width + block - 1) / block, rows = (height + block - 1) / block;
+    Range range;
+    range.col0 = static_cast<int>(std::clamp(std::floor(origin_x_ / cell), 0.0, static_cast<double>(cols)));
+    range.row0 = static_cast<int>(std::clamp(std::floor(origin_y_ / cell), 0.0, static_cast<double>(rows)));
+    range.col1 = static_cast<int>(std::clamp(std::ceil((origin_x_ + viewport_.w / zoom_) / cell), 0.0, static_cast<double>(cols)));
+    range.row1 = static_cast<int>(std::clamp(std::ceil((origin_y_ + viewport_.h / zoom_) / cell), 0.0, static_cast<double>(rows)));
+    return range;
+}
+
+Camera::Rect Camera::cell_rect(int col, int row, int block) const {
+    double cell = static_cast<double>(Constants::FIELD_SPACING) * block;
+    double gap = (Constants::FIELD_SPACING - Constants::FIELD_SIZE) * zoom_ >= 1.0 && block == 1 ? Constants::FIELD_SPACING - Constants::FIELD_SIZE : 0.0;
+    // Edges are rounded, not sizes, so neighbouring cells meet without seams.
+    int x0 = viewport_.x + static_cast<int>(std::lround((col * cell - origin_x_) * zoom_));
+    int y0 = viewport_.y + static_cast<int>(std::lround((row * cell - origin_y_) * zoom_));
+    int x1 = viewport_.x + static_cast<int>(std::lround(((col + 1) * cell - gap - origin_x_) * zoom_));
+    int y1 = viewport_.y + static_cast<int>(std::lround(((row + 1) * cell - gap - origin_y_) * zoom_));
+    return Rect{x0, y0, std::max(1, x1 - x0), std::max(1, y1 - y0)};
+}
+
+int Camera::lod_block() const {
+    if (plot_pixels() >= Constants::LOD_MIN_PLOT_PIXELS) return 1;
+    // Whole summary blocks, doubled until a tile covers enough pixels.
+    int block = Constants::FIELD_BLOCK;
+    while (block * plot_pixels() < Constants::LOD_MIN_TILE_PIXELS) block *= 2;
+    return block;
+}
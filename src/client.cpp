@@ -0,0 +1,209 @@
+#include "client.h"
+#include "renderer.h"
+#include "savemanager.h"
+#include "replay.h"
+#include "journal.h"
+#include "simthread.h"
+#include "timing.h"
+#include "log.h"
+#include "profiler.h"
+#include <SDL2/SDL.h>
+#include <cmath>
+#include <future>
+
+int run_client(const ClientOptions& options, const FrameHook& before_frame, ClientSummary* summary) {
+    const int64_t start_ns = Timing::now_ns();
+    Profile::Profiler& profiler = Profile::Profiler::instance();
+    profiler.name_thread("main");
+    if (!options.trace_path.empty()) profiler.start_trace();
+    // The save is read on another thread while the window comes up. It only
+    // reads: nothing writes the save files until the load is done.
+    std::future<Game> loading = std::async(std::launch::async, [&options] {
+        Profile::Profiler::instance().name_thread("load");
+        PROFILE_ZONE("load_save");
+        Game game;
+        SaveManager::load(game, options.save_path);
+        if (options.seeded) game.seed_rng(options.seed);
+        return game;
+    });
+    Renderer renderer;
+    if (!renderer.init(options.vsync, options.software)) return 1; // Waits for the load on the way out
+    const int64_t window_ns = Timing::now_ns();
+    Game game = loading.get();
+    const int64_t loaded_ns = Timing::now_ns();
+    int64_t first_frame_ns = 0;
+
+    // Opening the journal deletes the old segments, and commands recovered
+    // from them exist nowhere else yet. The loaded (recovered, fast-forwarded
+    // or reseeded) game is therefore always written out first, so the new
+    // segment continues from the state on disk. If that fails the client
+    // does not start: the old snapshot and segments still recover the game.
+    if (!SaveManager::save(game, options.save_path)) {
+        LOG_ERROR("Cannot write the save, not starting so the journal is kept", {"path", options.save_path});
+        return 1;
+    }
+    // Snapshots are rare; the journal keeps every change in between.
+    SaveService save_service(options.save_path, Constants::SNAPSHOT_INTERVAL);
+    save_service.start(game);
+    Journal journal(options.save_path);
+    journal.open(game);
+    bool running = true;
+    Screen current_screen = Screen::FIELD;
+    SDL_Event event;
+    FrameLimiter limiter(options.vsync ? 0.0 : options.target_fps);
+    RateCounter frame_counter;
+    CommandLog command_log;
+    if (!options.record_path.empty()) command_log.begin(game, FixedTimestep(options.tick_rate).get_dt());
+    // From here until stop() the game is the simulation thread's; this thread
+    // only sends it actions and draws its snapshots.
+    SimThread sim(game, journal, save_service, options.tick_rate, options.record_path.empty() ? nullptr : &command_log);
+    sim.set_uncapped(options.uncapped_ticks);
+    const Uint32 snapshot_event = SDL_RegisterEvents(1);
+    if (options.adaptive) {
+        sim.set_adaptive(true);
+        // Wakes this thread from SDL_WaitEvent when a snapshot changes the picture.
+        sim.set_on_change([snapshot_event] {
+            SDL_Event wake{};
+            wake.type = snapshot_event;
+            SDL_PushEvent(&wake);
+        });
+    }
+    sim.start();
+    auto send = [&](ActionType type, int index = 0) {
+        if (!sim.send(Action{type, index})) LOG_WARN("Action queue full, input dropped");
+    };
+    // Last pointer position seen in events; the wheel zooms about it. Tracked
+    // here rather than read from SDL_GetMouseState so injected input replays exactly.
+    int pointer_x = 0, pointer_y = 0;
+    // Returns whether the event changed the view, so the adaptive loop knows to draw.
+    auto handle_event = [&](const SDL_Event& event) {
+        const RenderSnapshot& state = sim.latest();
+        Camera& camera = renderer.get_camera();
+        // The camera is kept clamped after every move, not only when drawn, so a
+        // run of input events between frames acts the same as one per frame.
+        auto camera_moved = [&] {
+            if (state.width > 0) camera.clamp(state.width, state.height);
+            return true;
+        };
+        if (event.type == SDL_MOUSEMOTION) {
+            pointer_x = event.motion.x;
+            pointer_y = event.motion.y;
+        }
+        if (event.type == SDL_QUIT) {
+            running = false;
+        } else if (event.type == SDL_WINDOWEVENT) {
+            return true; // Exposed, resized or restored
+        } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3) {
+            renderer.toggle_profile_overlay();
+            return true;
+        } else if (event.type == SDL_KEYDOWN && current_screen == Screen::FIELD) {
+            // Arrow keys pan the field, Home restores the default view
+            switch (event.key.keysym.sym) {
+                case SDLK_LEFT: camera.pan(Constants::CAMERA_PAN_STEP, 0); return camera_moved();
+                case SDLK_RIGHT: camera.pan(-Constants::CAMERA_PAN_STEP, 0); return camera_moved();
+                case SDLK_UP: camera.pan(0, Constants::CAMERA_PAN_STEP); return camera_moved();
+                case SDLK_DOWN: camera.pan(0, -Constants::CAMERA_PAN_STEP); return camera_moved();
+                case SDLK_HOME: camera.reset(); return camera_moved();
+                default: break;
+            }
+        } else if (event.type == SDL_MOUSEWHEEL && current_screen == Screen::FIELD) {
+            camera.zoom_at(std::pow(Constants::CAMERA_ZOOM_STEP, event.wheel.y), pointer_x, pointer_y);
+            return camera_moved();
+        } else if (event.type == SDL_MOUSEMOTION && (event.motion.state & SDL_BUTTON_RMASK) && current_screen == Screen::FIELD) {
+            camera.pan(event.motion.xrel, event.motion.yrel);
+            return camera_moved();
+        } else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
+            int x = event.button.x, y = event.button.y;
+            // Navigation buttons
+            if (x >= Constants::WINDOW_WIDTH - 150 && x < Constants::WINDOW_WIDTH - 110 && y >= 10 && y < 50) {
+                current_screen = Screen::FIELD;
+            } else if (x >= Constants::WINDOW_WIDTH - 100 && x < Constants::WINDOW_WIDTH - 60 && y >= 10 && y < 50) {
+                current_screen = Screen::INVENTORY;
+            } else if (x >= Constants::WINDOW_WIDTH - 50 && x < Constants::WINDOW_WIDTH - 10 && y >= 10 && y < 50) {
+                current_screen = Screen::REFINING;
+            }
+            // Screen-specific interactions
+            if (current_screen == Screen::FIELD) {
+                size_t plot = camera.plot_at(x, y, state.width, state.height);
+                if (plot != Camera::NPOS) send(ActionType::TAP_PLOT, static_cast<int>(plot));
+            } else if (current_screen == Screen::REFINING) {
+                if (x >= Constants::BUTTON_X && x <= Constants::BUTTON_X + Constants::BUTTON_WIDTH &&
+                    y >= Constants::REFINE_BUTTON_Y && y <= Constants::REFINE_BUTTON_Y + Constants::BUTTON_HEIGHT) {
+                    send(ActionType::START_REFINING);
+                } else if (x >= Constants::BUTTON_X && x <= Constants::BUTTON_X + Constants::BUTTON_WIDTH &&
+                           y >= Constants::FLAME_BUTTON_Y && y <= Constants::FLAME_BUTTON_Y + Constants::BUTTON_HEIGHT) {
+                    send(ActionType::NEXT_FLAME);
+                }
+            }
+        }
+        return false;
+    };
+
+    bool redraw = true;
+    while (running) {
+        profiler.collect(); // Previous frame's zones, before the overlay reads them
+        PROFILE_ZONE("frame"); // Whole frame period, including the limiter wait
+        sim.refresh();
+        if (before_frame) before_frame(sim.latest());
+        if (options.adaptive && !redraw && !renderer.is_stale(sim.latest(), current_screen)) {
+            // Nothing on screen would change: block until input, a changed
+            // snapshot or the next tick of a visible countdown.
+            PROFILE_ZONE("idle");
+            int64_t still_ns = renderer.get_still_ns(sim.latest(), current_screen);
+            int got = still_ns < 0 ? SDL_WaitEvent(&event)
+                                   : SDL_WaitEventTimeout(&event, static_cast<int>((still_ns + 999999) / 1000000));
+            if (got) redraw = handle_event(event);
+            continue;
+        }
+
+        {
+            PROFILE_ZONE("input");
+            while (SDL_PollEvent(&event)) {
+                if (handle_event(event)) redraw = true;
+            }
+        }
+
+        const RenderSnapshot& state = sim.latest();
+        if (!options.adaptive || redraw || renderer.is_stale(state, current_screen)) {
+            frame_counter.add(Timing::now_ns());
+            renderer.set_loop_stats(frame_counter.get_rate(), state.tick_rate);
+            renderer.render(state, current_screen);
+            redraw = false;
+            if (first_frame_ns == 0) {
+                first_frame_ns = Timing::now_ns();
+                LOG_INFO("First frame ready", {"ms", (first_frame_ns - start_ns) / 1e6}, {"window_ms", (window_ns - start_ns) / 1e6},
+                         {"load_wait_ms", (loaded_ns - window_ns) / 1e6});
+            }
+        }
+        {
+            PROFILE_ZONE("wait");
+            limiter.wait();
+        }
+    }
+
+    sim.stop();
+    int64_t tick_count = sim.get_tick_count();
+    journal.rotate(game);
+    save_service.flush(game);
+    journal.retire(save_service.get_stats().last_revision);
+    journal.close();
+    save_service.stop();
+    if (summary) {
+        summary->ticks = tick_count;
+        summary->game = game.get_stats();
+        summary->saves = save_service.get_stats();
+        summary->journal_bytes = journal.get_bytes_written();
+        summary->first_frame_ms = first_frame_ns ? (first_frame_ns - start_ns) / 1e6 : 0.0;
+    }
+    if (!options.record_path.empty()) {
+        command_log.finish(tick_count);
+        if (command_log.save(options.record_path)) {
+            LOG_INFO("Recorded input log", {"commands", command_log.size()}, {"ticks", tick_count}, {"path", options.record_path});
+        }
+    }
+    if (!options.trace_path.empty()) {
+        profiler.collect();
+        if (profiler.write_trace(options.trace_path)) LOG_INFO("Wrote profile trace", {"path", options.trace_path});
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "farmhost.h"
+#include "constants.h"
+#include "timing.h"
+#include <algorithm>
+
+FarmHost::FarmHost(size_t threads) : pool_(threads), farm_bytes_(sizeof(Game)), chunk_size_(1) {}
+
+size_t FarmHost::add_farm(int width, int height, uint64_t seed) {
+    farms_.emplace_back(width, height, seed);
+    farm_bytes_ = std::max(farm_bytes_, sizeof(Game) + farms_.back().get_fields().memory_bytes());
+    update_chunk_size();
+    return farms_.size() - 1;
+}
+
+// Chunks hold as many consecutive farms as fit in FARM_CHUNK_BYTES, but are cut
+// smaller when there would otherwise be too few for idle workers to steal.
+void FarmHost::update_chunk_size() {
+    size_t by_cache = std::max<size_t>(1, Constants::FARM_CHUNK_BYTES / farm_bytes_);
+    size_t min_chunks = pool_.size() * Constants::FARM_CHUNKS_PER_THREAD;
+    size_t by_balance = std::max<size_t>(1, farms_.size() / min_chunks);
+    chunk_size_ = std::min(by_cache, by_balance);
+}
+
+void FarmHost::tick(double dt) {
+    tick(dt, nullptr);
+}
+
+void FarmHost::tick(double dt, const std::function<void(Game&)>& before) {
+    int64_t begin = Timing::now_ns();
+    pool_.parallel_for(farms_.size(), chunk_size_, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            if (before) before(farms_[i]);
+            farms_[i].update(dt);
+        }
+    });
+    int64_t elapsed = Timing::now_ns() - begin;
+    ++stats_.ticks;
+    stats_.last_ns = elapsed;
+    stats_.max_ns = std::max(stats_.max_ns, elapsed);
+    stats_.total_ns += elapsed;
+}
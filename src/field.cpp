@@ -1,34 +1,143 @@
 #include "field.h"
-#include <iostream>
+#include "log.h"
+#include "statehash.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
 
-Field::Field() : type_(Constants::EMPTY), growth_time_(Constants::DEFAULT_GROWTH_TIME), ready_(false) {}
+namespace {
+    uint64_t next_id() {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FieldStore::FieldStore(int width, int height)
+    : width_(width > 0 ? width : 1), height_(height > 0 ? height : 1),
+      size_(static_cast<size_t>(width_) * static_cast<size_t>(height_)),
+      blocks_wide_((width_ + Constants::FIELD_BLOCK - 1) / Constants::FIELD_BLOCK),
+      blocks_high_((height_ + Constants::FIELD_BLOCK - 1) / Constants::FIELD_BLOCK),
+      crops_(size_, Registry::EMPTY_ITEM), ready_at_(size_, 0), empty_((size_ + 63) / 64, ~uint64_t(0)),
+      growing_((size_ + 63) / 64, 0), ready_((size_ + 63) / 64, 0),
+      block_ready_(static_cast<size_t>(blocks_wide_) * blocks_high_, 0), block_growing_(block_ready_.size(), 0),
+      block_version_(block_ready_.size(), 0), hash_(0), id_(next_id()), version_(0) {
+    // Keep the padding bits of the last word clear so counts and scans stay exact.
+    if (size_ % 64) empty_.back() = (uint64_t(1) << (size_ % 64)) - 1;
+}
 
-void Field::plant(const std::string& type, double growth_time) {
-    type_ = type;
-    growth_time_ = growth_time;
-    start_time_ = std::chrono::steady_clock::now();
-    ready_ = false;
-    std::cout << "Planted " << type_ << std::endl;
+void FieldStore::plant(size_t i, ItemId crop, GameTime ready_at) {
+    restore(i, crop, ready_at, false);
+    LOG_DEBUG("Planted", {"type", Registry::get().item_name(crop)}, {"field", i});
 }
 
-void Field::update(double dt) {
-    if (type_ != Constants::EMPTY && !ready_) {
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::steady_clock::now() - start_time_).count() / Constants::MILLISECONDS_TO_SECONDS;
-        if (elapsed >= growth_time_) {
-            ready_ = true;
-            std::cout << "Field is ready for harvest: " << type_ << std::endl;
+void FieldStore::count_out(size_t i) {
+    hash_ ^= plot_key(i);
+    if (test(ready_, i)) --block_ready_[block_of(i)];
+    else if (test(growing_, i)) --block_growing_[block_of(i)];
+}
+
+void FieldStore::count_in(size_t i) {
+    hash_ ^= plot_key(i);
+    if (test(ready_, i)) ++block_ready_[block_of(i)];
+    else if (test(growing_, i)) ++block_growing_[block_of(i)];
+}
+
+uint64_t FieldStore::plot_key(size_t i) const {
+    if (test(empty_, i)) return 0;
+    uint64_t state = static_cast<uint64_t>(ready_at_[i]) << 1 | static_cast<uint64_t>(test(ready_, i));
+    return StateHash::key(StateHash::PLOT, i, Registry::get().item_key(crops_[i]) ^ StateHash::mix(state));
+}
+
+uint64_t FieldStore::compute_hash() const {
+    uint64_t hash = 0;
+    for (size_t i = next(growing_, 0); i != NPOS; i = next(growing_, i + 1)) hash ^= plot_key(i);
+    for (size_t i = next(ready_, 0); i != NPOS; i = next(ready_, i + 1)) hash ^= plot_key(i);
+    return hash;
+}
+
+int FieldStore::block_plots(size_t block) const {
+    int bx = static_cast<int>(block % blocks_wide_), by = static_cast<int>(block / blocks_wide_);
+    int w = std::min(Constants::FIELD_BLOCK, width_ - bx * Constants::FIELD_BLOCK);
+    int h = std::min(Constants::FIELD_BLOCK, height_ - by * Constants::FIELD_BLOCK);
+    return w * h;
+}
+
+void FieldStore::restore(size_t i, ItemId crop, GameTime ready_at, bool ready) {
+    count_out(i);
+    crops_[i] = crop;
+    ready_at_[i] = crop != Registry::EMPTY_ITEM ? ready_at : 0;
+    reset(empty_, i);
+    reset(growing_, i);
+    reset(ready_, i);
+    if (crop == Registry::EMPTY_ITEM) set(empty_, i);
+    else if (ready) set(ready_, i);
+    else set(growing_, i);
+    count_in(i);
+    touch(i);
+}
+
+bool FieldStore::mature(size_t i, GameTime now) {
+    if (!test(growing_, i) || ready_at_[i] > now) return false;
+    hash_ ^= plot_key(i);
+    reset(growing_, i);
+    set(ready_, i);
+    hash_ ^= plot_key(i);
+    size_t block = block_of(i);
+    --block_growing_[block];
+    ++block_ready_[block];
+    block_version_[block] = ++version_;
+    LOG_DEBUG("Field is ready for harvest", {"type", Registry::get().item_name(crops_[i])}, {"field", i});
+    return true;
+}
+
+ItemId FieldStore::harvest(size_t i) {
+    if (!test(ready_, i)) return Registry::EMPTY_ITEM;
+    ItemId crop = crops_[i];
+    restore(i, Registry::EMPTY_ITEM, 0, false);
+    LOG_DEBUG("Harvested", {"type", Registry::get().item_name(crop)}, {"field", i});
+    return crop;
+}
+
+size_t FieldStore::clear_growing(const uint64_t* mask) {
+    size_t lost = 0;
+    for (size_t w = 0; w < growing_.size(); ++w) {
+        uint64_t bits = mask ? growing_[w] & mask[w] : growing_[w];
+        if (!bits) continue;
+        lost += std::popcount(bits);
+        for (uint64_t left = bits; left; left &= left - 1) {
+            size_t i = w * 64 + std::countr_zero(left);
+            hash_ ^= plot_key(i); // While the plot still reads as growing
+            crops_[i] = Registry::EMPTY_ITEM;
+            ready_at_[i] = 0;
+            --block_growing_[block_of(i)];
+            touch(i);
         }
+        empty_[w] |= bits;
+        growing_[w] &= ~bits;
     }
+    return lost;
+}
+
+size_t FieldStore::memory_bytes() const {
+    return crops_.capacity() * sizeof(ItemId) + ready_at_.capacity() * sizeof(GameTime) +
+           (empty_.capacity() + growing_.capacity() + ready_.capacity()) * sizeof(uint64_t) +
+           (block_ready_.capacity() + block_growing_.capacity()) * sizeof(uint16_t) +
+           block_version_.capacity() * sizeof(uint64_t);
 }
 
-bool Field::harvest(std::string& harvested_type) {
-    if (ready_ && type_ != Constants::EMPTY) {
-        harvested_type = type_;
-        type_ = Constants::EMPTY;
-        ready_ = false;
-        std::cout << "Harvested " << harvested_type << std::endl;
-        return true;
+size_t FieldStore::count(const std::vector<uint64_t>& bits) {
+    size_t total = 0;
+    for (uint64_t word : bits) total += std::popcount(word);
+    return total;
+}
+
+size_t FieldStore::next(const std::vector<uint64_t>& bits, size_t from) const {
+    if (from >= size_) return NPOS;
+    size_t w = from >> 6;
+    uint64_t word = bits[w] & (~uint64_t(0) << (from & 63));
+    while (!word) {
+        if (++w >= bits.size()) return NPOS;
+        word = bits[w];
     }
-    return false;
-}
\ No newline at end of file
+    return w * 64 + std::countr_zero(word);
+}
@@ -1,86 +1,235 @@
 #include "game.h"
-#include <random>
-#include <iostream>
+#include "log.h"
+#include "statehash.h"
+#include <algorithm>
+#if ALCHEMIST_CHECK_HASH
+#include <cstdlib>
+#endif
 
-Game::Game() : fields_(Constants::FIELD_COUNT), inventory_(Constants::DEFAULT_INVENTORY),
-               proficiency_(0), refining_(false), refine_time_(0.0), flame_type_(Constants::LOW_FLAME), pest_timer_(0.0) {}
+Game::Game(int width, int height, uint64_t seed) : now_(0), skip_pests_until_(-1), rng_(seed), fields_(width, height),
+               proficiency_(0), refining_(false), refine_recipe_(0), refine_done_at_(0), flame_type_(Registry::get().low_flame), revision_(0) {
+    scheduler_.schedule(now_ + to_game_time(Constants::PEST_CHECK_INTERVAL), EventType::PEST_CHECK);
+}
 
 void Game::update(double dt) {
-    for (auto& field : fields_) {
-        field.update(dt);
-    }
-    if (refining_) {
-        refine_time_ -= dt;
-        if (refine_time_ <= 0) {
-            bool success = refine();
-            std::cout << "Refining " << (success ? "succeeded!" : "failed!") << std::endl;
-            refining_ = false;
-        }
+    advance_to(now_ + to_game_time(dt));
+}
+
+void Game::advance(double seconds) {
+    if (seconds <= 0) return;
+    GameTime target = now_ + to_game_time(seconds);
+    skip_pests_until_ = target;
+    advance_to(target); // Events that change the state bump the revision themselves
+    skip_pests_until_ = -1;
+}
+
+void Game::advance_to(GameTime time) {
+    if (time > now_) now_ = time;
+    ScheduledEvent event;
+    while (scheduler_.pop_due(now_, event)) {
+        handle_event(event);
     }
-    pest_timer_ += dt;
-    if (pest_timer_ >= Constants::PEST_CHECK_INTERVAL) {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0.0, 1.0);
-        if (dis(gen) < Constants::PEST_ATTACK_PROBABILITY) {
-            for (auto& field : fields_) {
-                if (!field.is_empty() && !field.is_ready()) {
-                    field.plant(Constants::EMPTY);
-                    std::cout << "Pest attack! Spirit grass lost!" << std::endl;
-                }
+    check_state_hash("advance");
+}
+
+void Game::handle_event(const ScheduledEvent& event) {
+    switch (event.type) {
+        case EventType::FIELD_READY:
+            // Stale if the field was harvested or lost since; mature() checks the plot's own ready time.
+            if (fields_.mature(event.target, now_)) ++revision_;
+            break;
+        case EventType::REFINE_DONE:
+            if (refining_ && refine_done_at_ <= now_) {
+                bool success = refine();
+                if (success) ++stats_.refines_succeeded;
+                else ++stats_.refines_failed;
+                LOG_INFO(success ? "Refining succeeded" : "Refining failed", {"flame", get_flame_name()});
+                refining_ = false;
+                ++revision_;
             }
+            break;
+        case EventType::PEST_CHECK: {
+            GameTime interval = to_game_time(Constants::PEST_CHECK_INTERVAL);
+            if (event.due <= skip_pests_until_) {
+                // Checks left up to the target, this one included; the first hit among
+                // them is geometric, so one roll settles them all.
+                uint64_t checks = static_cast<uint64_t>((skip_pests_until_ - event.due) / interval) + 1;
+                uint64_t misses = rng_.next_geometric(Constants::PEST_ATTACK_PROBABILITY);
+                if (misses < checks) scheduler_.schedule(event.due + static_cast<GameTime>(misses) * interval, EventType::PEST_ATTACK);
+                else scheduler_.schedule(event.due + static_cast<GameTime>(checks) * interval, EventType::PEST_CHECK);
+                break;
+            }
+            check_pests();
+            scheduler_.schedule(event.due + interval, EventType::PEST_CHECK);
+            break;
         }
-        pest_timer_ = 0.0;
+        case EventType::PEST_ATTACK:
+            pest_attack();
+            scheduler_.schedule(event.due + to_game_time(Constants::PEST_CHECK_INTERVAL), EventType::PEST_CHECK);
+            break;
     }
 }
 
-bool Game::plant(int idx, const std::string& type) {
-    if (idx >= 0 && idx < fields_.size() && fields_[idx].is_empty()) {
-        fields_[idx].plant(type);
-        return true;
+void Game::check_pests() {
+    if (rng_.next_double() < Constants::PEST_ATTACK_PROBABILITY) pest_attack();
+}
+
+void Game::pest_attack() {
+    ++stats_.pest_attacks;
+    const uint64_t* mask = nullptr;
+    if (Constants::PEST_PLOT_LOSS_PROBABILITY < 1.0) {
+        pest_mask_.resize(fields_.word_count());
+        rng_.fill_bernoulli(pest_mask_.data(), fields_.size(), Constants::PEST_PLOT_LOSS_PROBABILITY);
+        mask = pest_mask_.data();
     }
-    return false;
+    size_t lost = fields_.clear_growing(mask);
+    if (lost > 0) {
+        ++revision_;
+        stats_.fields_lost += lost;
+        LOG_INFO("Pest attack, spirit grass lost", {"lost", lost});
+    }
+}
+
+GameTime Game::next_wake_time() const {
+    GameTime next = refining_ ? refine_done_at_ : GAME_TIME_NEVER;
+    if (!scheduler_.empty() && fields_.count_growing() > 0) next = std::min(next, scheduler_.next_due());
+    return next;
 }
 
-bool Game::harvest(int idx, std::string& harvested_type) {
-    if (idx >= 0 && idx < fields_.size() && fields_[idx].is_ready()) {
-        if (fields_[idx].harvest(harvested_type)) {
-            inventory_[harvested_type]++;
-            return true;
+void Game::set_time(GameTime now) {
+    now_ = now;
+    scheduler_.clear();
+    // Pest checks run on a fixed cadence from time zero, so a loaded game keeps the same schedule.
+    GameTime interval = to_game_time(Constants::PEST_CHECK_INTERVAL);
+    scheduler_.schedule((now_ / interval + 1) * interval, EventType::PEST_CHECK);
+    for (size_t i = 0; i < fields_.size(); ++i) {
+        if (fields_.is_growing(i)) {
+            scheduler_.schedule(fields_.get_ready_at(i), EventType::FIELD_READY, static_cast<int32_t>(i));
         }
     }
-    return false;
+    if (refining_) scheduler_.schedule(refine_done_at_, EventType::REFINE_DONE);
+}
+
+bool Game::plant(int idx, ItemId crop) {
+    if (idx < 0 || static_cast<size_t>(idx) >= fields_.size() || !fields_.is_empty(idx)) return false;
+    if (crop == Registry::EMPTY_ITEM || crop >= Registry::get().item_count()) return false;
+    fields_.plant(idx, crop, now_ + to_game_time(Constants::DEFAULT_GROWTH_TIME));
+    scheduler_.schedule(fields_.get_ready_at(idx), EventType::FIELD_READY, idx);
+    ++revision_;
+    ++stats_.plants;
+    check_state_hash("plant");
+    return true;
+}
+
+void Game::set_rng_state(uint64_t seed, const Rng::State& state) {
+    rng_.seed(seed);
+    rng_.set_state(state);
+}
+
+bool Game::restore_field(int idx, ItemId crop, GameTime ready_at, bool ready) {
+    if (idx < 0 || static_cast<size_t>(idx) >= fields_.size() || crop >= Registry::get().item_count()) return false;
+    fields_.restore(idx, crop, ready_at, ready);
+    if (fields_.is_growing(idx)) {
+        scheduler_.schedule(ready_at, EventType::FIELD_READY, idx);
+    }
+    return true;
+}
+
+bool Game::restore_refining(size_t recipe, GameTime done_at) {
+    if (refining_ || recipe >= Registry::get().recipes().size()) return false;
+    refining_ = true;
+    refine_recipe_ = recipe;
+    refine_done_at_ = done_at;
+    scheduler_.schedule(refine_done_at_, EventType::REFINE_DONE);
+    return true;
+}
+
+bool Game::harvest(int idx, ItemId& harvested) {
+    if (idx < 0 || static_cast<size_t>(idx) >= fields_.size()) return false;
+    ItemId crop = fields_.harvest(idx);
+    if (crop == Registry::EMPTY_ITEM) return false;
+    harvested = crop;
+    inventory_.add(crop, 1);
+    ++revision_;
+    ++stats_.harvests;
+    check_state_hash("harvest");
+    return true;
+}
+
+size_t Game::find_recipe() const {
+    const auto& recipes = Registry::get().recipes();
+    for (size_t r = 0; r < recipes.size(); ++r) {
+        if (inventory_.get(recipes[r].input) >= recipes[r].input_count) return r;
+    }
+    return NO_RECIPE;
 }
 
 bool Game::start_refining() {
-    if (!refining_ && inventory_[Constants::FIRE_GRASS] >= Constants::FIRE_GRASS_REQUIRED) {
-        refining_ = true;
-        refine_time_ = Constants::REFINE_TIME;
-        std::cout << "Started refining with " << flame_type_ << " flame" << std::endl;
-        return true;
+    size_t recipe = refining_ ? NO_RECIPE : find_recipe();
+    if (recipe == NO_RECIPE) {
+        const auto& recipes = Registry::get().recipes();
+        if (refining_) {
+            LOG_INFO("Already refining");
+        } else if (!recipes.empty()) {
+            // Nothing can be refined; name what the first recipe is short of.
+            LOG_INFO("Not enough to refine", {"needs", Registry::get().item_name(recipes[0].input)},
+                     {"count", recipes[0].input_count});
+        }
+        return false;
     }
-    std::cout << "Not enough fire_grass or already refining!" << std::endl;
-    return false;
+    refining_ = true;
+    refine_recipe_ = recipe;
+    refine_done_at_ = now_ + to_game_time(Registry::get().recipes()[recipe].refine_time);
+    scheduler_.schedule(refine_done_at_, EventType::REFINE_DONE);
+    ++revision_;
+    ++stats_.refines_started;
+    LOG_INFO("Started refining", {"flame", get_flame_name()});
+    check_state_hash("start_refining");
+    return true;
 }
 
-void Game::set_flame_type(const std::string& flame) {
+void Game::set_flame_type(FlameId flame) {
+    if (flame >= Registry::get().flame_count()) return;
     flame_type_ = flame;
-    std::cout << "Flame set to " << flame_type_ << std::endl;
+    ++revision_;
+    LOG_INFO("Flame set", {"flame", get_flame_name()});
+    check_state_hash("set_flame_type");
+}
+
+void Game::set_proficiency(int proficiency) {
+    proficiency_ = proficiency;
+    ++revision_;
+    check_state_hash("set_proficiency");
 }
 
+uint64_t Game::scalar_hash() const {
+    uint64_t hash = StateHash::key(StateHash::FLAME, Registry::get().flame_key(flame_type_));
+    if (proficiency_ != 0) hash ^= StateHash::key(StateHash::PROFICIENCY, static_cast<uint32_t>(proficiency_));
+    if (refining_) hash ^= StateHash::key(StateHash::REFINING, refine_recipe_, static_cast<uint64_t>(refine_done_at_));
+    return hash;
+}
+
+#if ALCHEMIST_CHECK_HASH
+void Game::check_state_hash(const char* after) const {
+    uint64_t expected = compute_state_hash();
+    if (get_state_hash() == expected) return;
+    LOG_ERROR("State hash mismatch", {"after", after}, {"incremental", get_state_hash()}, {"recomputed", expected});
+    Log::Logger::instance().stop(); // Writes the record out before aborting
+    std::abort();
+}
+#endif
+
 bool Game::refine() {
-    if (inventory_[Constants::FIRE_GRASS] < Constants::FIRE_GRASS_REQUIRED) return false;
-    inventory_[Constants::FIRE_GRASS] -= Constants::FIRE_GRASS_REQUIRED;
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-    double success_rate = Constants::BASE_SUCCESS_RATE + proficiency_ * Constants::PROFICIENCY_BONUS;
-    if (flame_type_ == Constants::MID_FLAME) success_rate += Constants::MID_FLAME_BONUS;
-    else if (flame_type_ == Constants::HIGH_FLAME) success_rate += Constants::HIGH_FLAME_BONUS;
-    if (dis(gen) < success_rate) {
-        inventory_[Constants::PILL]++;
+    const Registry& registry = Registry::get();
+    const RecipeDef& recipe = registry.recipes()[refine_recipe_];
+    if (inventory_.get(recipe.input) < recipe.input_count) return false;
+    inventory_.add(recipe.input, -recipe.input_count);
+    double success_rate = recipe.base_success_rate + proficiency_ * Constants::PROFICIENCY_BONUS +
+                          registry.flame(flame_type_).bonus;
+    if (rng_.next_double() < success_rate) {
+        inventory_.add(recipe.output, 1);
         proficiency_ += Constants::PROFICIENCY_GAIN;
         return true;
     }
     return false;
-}
\ No newline at end of file
+}
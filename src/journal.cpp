@@ -0,0 +1,301 @@
+#include "journal.h"
+#include "log.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <unistd.h>
+
+namespace {
+    const char MAGIC[4] = {'A', 'L', 'C', 'J'};
+    constexpr uint32_t VERSION = 1;
+    constexpr size_t HEADER_BYTES = sizeof(MAGIC) + 4 + 8 + 4 * 8;
+
+    // Record types 0..3 are CommandType values.
+    constexpr uint8_t RECORD_ADVANCE = 0x10; // Clock reached this time
+    constexpr uint8_t RECORD_OUTCOME = 0x11; // Refines succeeded/failed, pest attacks, plots lost
+
+    size_t value_count(uint8_t type) {
+        switch (type) {
+            case static_cast<uint8_t>(CommandType::PLANT): return 2;
+            case static_cast<uint8_t>(CommandType::HARVEST): return 1;
+            case static_cast<uint8_t>(CommandType::START_REFINING): return 0;
+            case static_cast<uint8_t>(CommandType::SET_FLAME): return 1;
+            case RECORD_ADVANCE: return 0;
+            case RECORD_OUTCOME: return 4;
+        }
+        return SIZE_MAX;
+    }
+
+    // Closes a finished segment after forcing it to the disk, not just the OS cache.
+    void sync_and_close(std::FILE* file) {
+        std::fflush(file);
+        fsync(fileno(file));
+        std::fclose(file);
+    }
+
+    uint8_t fold(uint8_t check, uint8_t byte) {
+        return static_cast<uint8_t>(((check << 1) | (check >> 7)) ^ byte);
+    }
+
+    void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void put_u64(std::vector<uint8_t>& out, uint64_t value, size_t bytes = 8) {
+        for (size_t i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    // Reads from a segment while folding every byte into the record checksum.
+    struct Reader {
+        std::FILE* file;
+        uint8_t check = 0;
+
+        bool byte(uint8_t& value) {
+            int c = std::fgetc(file);
+            if (c == EOF) return false;
+            value = static_cast<uint8_t>(c);
+            check = fold(check, value);
+            return true;
+        }
+        bool varint(uint64_t& value) {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t b;
+                if (!byte(b)) return false;
+                value |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if (!(b & 0x80)) return true;
+            }
+            return false;
+        }
+        bool u64(uint64_t& value, size_t bytes = 8) {
+            value = 0;
+            for (size_t i = 0; i < bytes; ++i) {
+                uint8_t b;
+                if (!byte(b)) return false;
+                value |= static_cast<uint64_t>(b) << (8 * i);
+            }
+            return true;
+        }
+    };
+
+    bool outcomes_match(const GameStats& a, const GameStats& b) {
+        return a.refines_succeeded == b.refines_succeeded && a.refines_failed == b.refines_failed &&
+               a.pest_attacks == b.pest_attacks && a.fields_lost == b.fields_lost;
+    }
+
+    // Replays one segment; false means recovery must stop here.
+    bool replay_segment(const std::string& path, Game& game, size_t& applied) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return true;
+        Reader reader{file};
+        char magic[sizeof(MAGIC)];
+        uint64_t version = 0, base_time = 0;
+        Rng::State rng{};
+        bool header = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                      reader.u64(version, 4) && version == VERSION && reader.u64(base_time);
+        for (size_t i = 0; header && i < rng.size(); ++i) header = reader.u64(rng[i]);
+        if (!header) {
+            LOG_WARN("Journal segment has no valid header, skipped", {"path", path});
+            std::fclose(file);
+            return true;
+        }
+        if (static_cast<GameTime>(base_time) != game.get_time() || rng != game.get_rng().get_state()) {
+            LOG_INFO("Journal segment does not continue the loaded state, skipped", {"path", path});
+            std::fclose(file);
+            return true;
+        }
+
+        GameTime time = game.get_time();
+        GameStats expected = game.get_stats();
+        bool ok = true;
+        while (true) {
+            reader.check = 0;
+            uint8_t type;
+            if (!reader.byte(type)) break; // Clean end of segment
+            size_t count = value_count(type);
+            uint64_t delta, values[4] = {};
+            bool complete = count != SIZE_MAX && reader.varint(delta);
+            for (size_t i = 0; complete && i < count; ++i) complete = reader.varint(values[i]);
+            uint8_t check = reader.check, stored;
+            if (!complete || !reader.byte(stored) || stored != check) {
+                LOG_WARN("Journal ends in a torn or corrupt record, recovery stops there", {"path", path}, {"records", applied});
+                ok = false;
+                break;
+            }
+
+            time += static_cast<GameTime>(delta);
+            game.advance_to(time);
+            if (type == RECORD_OUTCOME) {
+                expected.refines_succeeded += values[0];
+                expected.refines_failed += values[1];
+                expected.pest_attacks += values[2];
+                expected.fields_lost += values[3];
+            } else if (type != RECORD_ADVANCE) {
+                Command command{0, static_cast<CommandType>(type), 0, 0};
+                if (command.type == CommandType::PLANT || command.type == CommandType::HARVEST) command.index = static_cast<int32_t>(values[0]);
+                if (command.type == CommandType::PLANT) command.id = static_cast<uint16_t>(values[1]);
+                if (command.type == CommandType::SET_FLAME) command.id = static_cast<uint16_t>(values[0]);
+                execute_command(game, command);
+            }
+            if (!outcomes_match(game.get_stats(), expected)) {
+                LOG_WARN("Journal replay diverged from the recorded outcomes, recovery stops there", {"path", path}, {"time_ns", time});
+                ok = false;
+                break;
+            }
+            ++applied;
+        }
+        std::fclose(file);
+        return ok;
+    }
+}
+
+Journal::Journal(const std::string& save_path)
+    : save_path_(save_path), file_(nullptr), last_time_(0), segment_bytes_(0), bytes_written_(0) {}
+
+Journal::~Journal() {
+    close();
+}
+
+std::vector<std::pair<uint64_t, std::string>> Journal::list_segments(const std::string& save_path) {
+    std::filesystem::path base(save_path + Constants::JOURNAL_SUFFIX + ".");
+    std::filesystem::path dir = base.parent_path().empty() ? std::filesystem::path(".") : base.parent_path();
+    std::string prefix = base.filename().string();
+    std::vector<std::pair<uint64_t, std::string>> segments;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) continue;
+        std::string number = name.substr(prefix.size());
+        if (number.find_first_not_of("0123456789") != std::string::npos) continue;
+        segments.emplace_back(std::stoull(number), (base.parent_path() / name).string());
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+bool Journal::open(const Game& base) {
+    close();
+    segments_.clear();
+    uint64_t number = 0;
+    for (const auto& [existing, path] : list_segments(save_path_)) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        number = existing + 1;
+    }
+    return start_segment(number, base);
+}
+
+bool Journal::start_segment(uint64_t number, const Game& base) {
+    std::string path = save_path_ + Constants::JOURNAL_SUFFIX + "." + std::to_string(number);
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        LOG_ERROR("Cannot open journal segment", {"path", path});
+        return false;
+    }
+    std::vector<uint8_t> header(MAGIC, MAGIC + sizeof(MAGIC));
+    put_u64(header, VERSION, 4);
+    put_u64(header, static_cast<uint64_t>(base.get_time()));
+    for (uint64_t word : base.get_rng().get_state()) put_u64(header, word);
+    std::fwrite(header.data(), 1, header.size(), file_);
+    std::fflush(file_);
+    segments_.push_back(Segment{number, base.get_revision(), path});
+    last_time_ = base.get_time();
+    last_stats_ = base.get_stats();
+    segment_bytes_ = HEADER_BYTES;
+    bytes_written_ += HEADER_BYTES;
+    return true;
+}
+
+void Journal::close() {
+    if (!file_) return;
+    sync_and_close(file_);
+    file_ = nullptr;
+    // A segment without records is never needed for recovery.
+    if (segment_bytes_ == HEADER_BYTES && !segments_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(segments_.back().path, ec);
+        segments_.pop_back();
+    }
+}
+
+void Journal::append(uint8_t type, const Game& game, std::initializer_list<uint64_t> values) {
+    if (!file_) return;
+    std::vector<uint8_t> record;
+    record.push_back(type);
+    put_varint(record, static_cast<uint64_t>(game.get_time() - last_time_));
+    for (uint64_t value : values) put_varint(record, value);
+    uint8_t check = 0;
+    for (uint8_t byte : record) check = fold(check, byte);
+    record.push_back(check);
+    // Flushed per record so a process crash loses at most the record being
+    // written. Only segment boundaries are fsynced, since a sync per record
+    // would stall the simulation thread.
+    std::fwrite(record.data(), 1, record.size(), file_);
+    std::fflush(file_);
+    last_time_ = game.get_time();
+    segment_bytes_ += record.size();
+    bytes_written_ += record.size();
+}
+
+void Journal::record(const Game& game, const Command& command) {
+    // Outcomes that happened before the command must come first in the journal.
+    observe(game);
+    uint8_t type = static_cast<uint8_t>(command.type);
+    switch (command.type) {
+        case CommandType::PLANT:
+            append(type, game, {static_cast<uint64_t>(command.index), command.id});
+            break;
+        case CommandType::HARVEST:
+            append(type, game, {static_cast<uint64_t>(command.index)});
+            break;
+        case CommandType::START_REFINING:
+            append(type, game, {});
+            break;
+        case CommandType::SET_FLAME:
+            append(type, game, {command.id});
+            break;
+    }
+}
+
+void Journal::observe(const Game& game) {
+    const GameStats& stats = game.get_stats();
+    if (outcomes_match(stats, last_stats_)) {
+        // Keeps the recovered clock (and with it growth and refining) close to the crash.
+        if (game.get_time() - last_time_ >= to_game_time(Constants::JOURNAL_CLOCK_INTERVAL)) append(RECORD_ADVANCE, game, {});
+        return;
+    }
+    append(RECORD_OUTCOME, game, {stats.refines_succeeded - last_stats_.refines_succeeded, stats.refines_failed - last_stats_.refines_failed,
+                                  stats.pest_attacks - last_stats_.pest_attacks, stats.fields_lost - last_stats_.fields_lost});
+    last_stats_ = stats;
+}
+
+bool Journal::rotate(const Game& base) {
+    if (file_) {
+        observe(base);
+        if (base.get_time() != last_time_) append(RECORD_ADVANCE, base, {});
+        sync_and_close(file_);
+        file_ = nullptr;
+    }
+    return start_segment(segments_.empty() ? 0 : segments_.back().number + 1, base);
+}
+
+void Journal::retire(uint64_t saved_revision) {
+    while (segments_.size() > 1 && segments_[1].base_revision <= saved_revision) {
+        std::error_code ec;
+        std::filesystem::remove(segments_.front().path, ec);
+        segments_.erase(segments_.begin());
+    }
+}
+
+size_t Journal::recover(const std::string& save_path, Game& game) {
+    size_t applied = 0;
+    for (const auto& [number, path] : list_segments(save_path)) {
+        if (!replay_segment(path, game, applied)) break;
+    }
+    if (applied > 0) LOG_INFO("Recovered from journal", {"records", applied}, {"time_ns", game.get_time()});
+    return applied;
+}
@@ -0,0 +1,82 @@
+#include "jsonwriter.h"
+#include <cassert>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+void JsonWriter::newline(size_t depth) {
+    out_.push_back('\n');
+    out_.append(depth * indent_, ' ');
+}
+
+void JsonWriter::separate() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (depth_ == 0) return;
+    if (counts_[depth_ - 1]++ > 0) out_.push_back(',');
+    newline(depth_);
+}
+
+void JsonWriter::open(char bracket) {
+    separate();
+    out_.push_back(bracket);
+    assert(depth_ < MAX_DEPTH);
+    counts_[depth_++] = 0;
+}
+
+void JsonWriter::close(char bracket) {
+    --depth_;
+    if (counts_[depth_] > 0) newline(depth_);
+    out_.push_back(bracket);
+}
+
+void JsonWriter::key(std::string_view name) {
+    value(name);
+    out_.append(": ");
+    after_key_ = true;
+}
+
+void JsonWriter::value(bool b) {
+    separate();
+    out_.append(b ? "true" : "false");
+}
+
+void JsonWriter::value(double d) {
+    separate();
+    if (!std::isfinite(d)) {
+        out_.append("null"); // As dump() writes NaN and infinities
+        return;
+    }
+    // dump()'s own formatter (Grisu2 digits, whole numbers with ".0",
+    // exponents as e+NN), so saves match the old writer byte for byte.
+    char buffer[64];
+    char* end = nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer), d);
+    out_.append(buffer, end);
+}
+
+void JsonWriter::value(std::string_view s) {
+    separate();
+    out_.push_back('"');
+    for (char c : s) {
+        switch (c) {
+            case '"': out_.append("\\\""); break;
+            case '\\': out_.append("\\\\"); break;
+            case '\b': out_.append("\\b"); break;
+            case '\f': out_.append("\\f"); break;
+            case '\n': out_.append("\\n"); break;
+            case '\r': out_.append("\\r"); break;
+            case '\t': out_.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    static const char HEX[] = "0123456789abcdef";
+                    out_.append("\\u00");
+                    out_.push_back(HEX[c >> 4]);
+                    out_.push_back(HEX[c & 0xf]);
+                } else {
+                    out_.push_back(c);
+                }
+        }
+    }
+    out_.push_back('"');
+}
@@ -0,0 +1,183 @@
+#include "log.h"
+#include "timing.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace Log {
+    namespace {
+        const char* const LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+        constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(2);
+        const int64_t START_NS = Timing::now_ns();
+    }
+
+    // Bounded MPMC queue slot (Vyukov): the sequence number says whether the
+    // slot is free for the producer of a given ticket or full for its consumer.
+    struct Logger::Slot {
+        std::atomic<uint64_t> sequence;
+        Record record;
+    };
+
+    Field::Field(const char* key, std::string_view value) : key(key), kind(Kind::TEXT) {
+        size_t length = std::min(value.size(), TEXT_CAPACITY - 1);
+        std::memcpy(text, value.data(), length);
+        text[length] = '\0';
+    }
+
+    void write(Level level, const char* message, const Field& a, const Field& b, const Field& c, const Field& d) {
+        Record record;
+        record.time_ns = Timing::now_ns();
+        record.message = message;
+        record.level = level;
+        record.field_count = 0;
+        for (const Field* field : {&a, &b, &c, &d}) {
+            if (field->key) record.fields[record.field_count++] = *field;
+        }
+        Logger::instance().push(record);
+    }
+
+    Logger& Logger::instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    Logger::Logger() : slots_(new Slot[CAPACITY]), head_(0), tail_(0), running_(false), pushing_(0), dropped_(0), written_(0), out_(nullptr) {
+        for (size_t i = 0; i < CAPACITY; ++i) slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    Logger::~Logger() {
+        stop();
+    }
+
+    bool Logger::start(const std::string& path) {
+        if (running_.load()) return true;
+        out_ = stdout;
+        if (!path.empty()) {
+            out_ = std::fopen(path.c_str(), "a");
+            if (!out_) {
+                std::fprintf(stderr, "Log Error: cannot open %s\n", path.c_str());
+                out_ = nullptr;
+                return false;
+            }
+        }
+        running_.store(true);
+        worker_ = std::thread(&Logger::run, this);
+        return true;
+    }
+
+    void Logger::stop() {
+        if (!running_.exchange(false)) return;
+        worker_.join();
+        if (out_ && out_ != stdout) std::fclose(out_);
+        else if (out_) std::fflush(out_);
+        out_ = nullptr;
+        uint64_t dropped = get_dropped();
+        if (dropped) std::fprintf(stderr, "Log: %llu records dropped\n", static_cast<unsigned long long>(dropped));
+    }
+
+    void Logger::push(const Record& record) {
+        // Announced before running_ is read, and both sequentially consistent,
+        // so the worker's final drain either sees this push or it sees stop().
+        pushing_.fetch_add(1);
+        if (!running_.load()) {
+            pushing_.fetch_sub(1, std::memory_order_relaxed);
+            if (record.level >= Level::WARN) format(stderr, record);
+            else dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!try_push(record)) dropped_.fetch_add(1, std::memory_order_relaxed);
+        pushing_.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool Logger::try_push(const Record& record) {
+        uint64_t ticket = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[ticket & (CAPACITY - 1)];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(ticket);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+                    slot.record = record;
+                    slot.sequence.store(ticket + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                ticket = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool Logger::try_pop(Record& record) {
+        uint64_t ticket = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[ticket & (CAPACITY - 1)];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(ticket + 1);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+                    record = slot.record;
+                    slot.sequence.store(ticket + CAPACITY, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Empty
+            } else {
+                ticket = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Logger::run() {
+        Record record;
+        while (true) {
+            bool drained_any = false;
+            while (try_pop(record)) {
+                format(out_, record);
+                written_.fetch_add(1, std::memory_order_relaxed);
+                drained_any = true;
+            }
+            if (drained_any) std::fflush(out_);
+            if (!running_.load()) {
+                // Producers may still have been mid-push when stop() was called:
+                // keep draining until none is, then take what they left.
+                bool idle;
+                do {
+                    idle = pushing_.load() == 0;
+                    while (try_pop(record)) {
+                        format(out_, record);
+                        written_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    if (!idle) std::this_thread::yield();
+                } while (!idle);
+                std::fflush(out_);
+                return;
+            }
+            std::this_thread::sleep_for(DRAIN_INTERVAL);
+        }
+    }
+
+    void Logger::format(std::FILE* out, const Record& record) {
+        std::fprintf(out, "[%12.6f] %-5s %s", (record.time_ns - START_NS) / 1e9,
+                     LEVEL_NAMES[static_cast<int>(record.level)], record.message);
+        for (uint8_t i = 0; i < record.field_count; ++i) {
+            const Field& field = record.fields[i];
+            switch (field.kind) {
+                case Field::Kind::INT:
+                    std::fprintf(out, " %s=%lld", field.key, static_cast<long long>(field.i));
+                    break;
+                case Field::Kind::UINT:
+                    std::fprintf(out, " %s=%llu", field.key, static_cast<unsigned long long>(field.u));
+                    break;
+                case Field::Kind::DOUBLE:
+                    std::fprintf(out, " %s=%g", field.key, field.d);
+                    break;
+                case Field::Kind::TEXT:
+                    std::fprintf(out, " %s=%s", field.key, field.text);
+                    break;
+            }
+        }
+        std::fputc('\n', out);
+    }
+}
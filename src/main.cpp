@@ -1,70 +1,38 @@
-#include "game.h"
-#include "renderer.h"
-#include "savemanager.h"
+#include "client.h"
 #include "constants.h"
-#include <SDL2/SDL.h>
-#include <chrono>
+#include "log.h"
+#include <cstdlib>
+#include <cstring>
 
 int main(int argc, char* argv[]) {
-    Renderer renderer;
-    if (!renderer.init()) return 1;
-
-    Game game;
-    SaveManager::load(game);
-    bool running = true;
-    Screen current_screen = Screen::FIELD;
-    SDL_Event event;
-    auto last_time = std::chrono::steady_clock::now();
-
-    while (running) {
-        auto now = std::chrono::steady_clock::now();
-        double dt = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_time).count() / Constants::MILLISECONDS_TO_SECONDS;
-        last_time = now;
-
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                running = false;
-            } else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
-                int x = event.button.x, y = event.button.y;
-                // Navigation buttons
-                if (x >= Constants::WINDOW_WIDTH - 150 && x < Constants::WINDOW_WIDTH - 110 && y >= 10 && y < 50) {
-                    current_screen = Screen::FIELD;
-                } else if (x >= Constants::WINDOW_WIDTH - 100 && x < Constants::WINDOW_WIDTH - 60 && y >= 10 && y < 50) {
-                    current_screen = Screen::INVENTORY;
-                } else if (x >= Constants::WINDOW_WIDTH - 50 && x < Constants::WINDOW_WIDTH - 10 && y >= 10 && y < 50) {
-                    current_screen = Screen::REFINING;
-                }
-                // Screen-specific interactions
-                if (current_screen == Screen::FIELD && x >= Constants::FIELD_START_X && x < Constants::FIELD_START_X + Constants::FIELD_GRID_WIDTH &&
-                    y >= Constants::FIELD_START_Y && y < Constants::FIELD_START_Y + Constants::FIELD_GRID_HEIGHT) {
-                    int idx = ((y - Constants::FIELD_START_Y) / Constants::FIELD_SPACING) * Constants::GRID_SIZE +
-                             ((x - Constants::FIELD_START_X) / Constants::FIELD_SPACING);
-                    if (idx >= 0 && idx < Constants::FIELD_COUNT) {
-                        std::string harvested_type;
-                        if (!game.plant(idx, Constants::FIRE_GRASS)) {
-                            game.harvest(idx, harvested_type);
-                        }
-                    }
-                } else if (current_screen == Screen::REFINING) {
-                    if (x >= Constants::BUTTON_X && x <= Constants::BUTTON_X + Constants::BUTTON_WIDTH &&
-                        y >= Constants::REFINE_BUTTON_Y && y <= Constants::REFINE_BUTTON_Y + Constants::BUTTON_HEIGHT) {
-                        game.start_refining();
-                    } else if (x >= Constants::BUTTON_X && x <= Constants::BUTTON_X + Constants::BUTTON_WIDTH &&
-                               y >= Constants::FLAME_BUTTON_Y && y <= Constants::FLAME_BUTTON_Y + Constants::BUTTON_HEIGHT) {
-                        std::string flame = game.get_flame_type();
-                        if (flame == Constants::LOW_FLAME) game.set_flame_type(Constants::MID_FLAME);
-                        else if (flame == Constants::MID_FLAME) game.set_flame_type(Constants::HIGH_FLAME);
-                        else game.set_flame_type(Constants::LOW_FLAME);
-                    }
-                }
-            }
+    ClientOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            options.tick_rate = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            options.target_fps = std::atof(argv[++i]); // 0 disables the limiter
+        } else if (std::strcmp(argv[i], "--vsync") == 0) {
+            options.vsync = true;
+        } else if (std::strcmp(argv[i], "--busy-loop") == 0) {
+            options.adaptive = false; // Tick and draw at the fixed rates even when idle, e.g. for profiling
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seeded = true;
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            options.record_path = argv[++i]; // Input log for alchemist_sim --replay
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options.trace_path = argv[++i]; // Chrome trace of the profiling zones, written on exit
+        } else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            options.save_path = argv[++i]; // A .bin path selects the binary format
         }
-
-        game.update(dt);
-        renderer.render(game, current_screen);
-        SaveManager::save(game);
-        SDL_Delay(Constants::FRAME_DELAY);
+    }
+    if (options.tick_rate <= 0) {
+        LOG_WARN("Invalid tick rate, using the default", {"tick_rate", Constants::TICK_RATE});
+        options.tick_rate = Constants::TICK_RATE;
     }
 
-    return 0;
-}
\ No newline at end of file
+    Log::Logger::instance().start();
+    int status = run_client(options);
+    Log::Logger::instance().stop();
+    return status;
+}
@@ -0,0 +1,147 @@
+#include "profiler.h"
+#include "log.h"
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+
+namespace Profile {
+    // Single-producer single-consumer ring: the owning thread advances head,
+    // the collector advances tail. Buffers outlive their threads so late events
+    // are still collected.
+    struct Profiler::ThreadBuffer {
+        static constexpr size_t MASK = Constants::PROFILE_BUFFER_CAPACITY - 1;
+        static_assert((Constants::PROFILE_BUFFER_CAPACITY & MASK) == 0, "capacity must be a power of two");
+
+        std::string name;
+        std::unique_ptr<Event[]> events{new Event[Constants::PROFILE_BUFFER_CAPACITY]};
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    Profiler& Profiler::instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    Profiler::Profiler() : start_ns_(Timing::now_ns()), trace_capacity_(0), trace_dropped_(0) {}
+
+    uint16_t Profiler::register_zone(const char* name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t id = 0; id < zone_names_.size(); ++id) {
+            if (std::string_view(zone_names_[id]) == name) return static_cast<uint16_t>(id);
+        }
+        zone_names_.push_back(name);
+        return static_cast<uint16_t>(zone_names_.size() - 1);
+    }
+
+    Profiler::ThreadBuffer& Profiler::local_buffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.push_back(std::make_unique<ThreadBuffer>());
+            buffer = buffers_.back().get();
+            buffer->name = "thread " + std::to_string(buffers_.size());
+        }
+        return *buffer;
+    }
+
+    void Profiler::record(uint16_t zone, int64_t start_ns, int64_t end_ns) {
+        ThreadBuffer& buffer = local_buffer();
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        if (head - buffer.tail.load(std::memory_order_acquire) > ThreadBuffer::MASK) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.events[head & ThreadBuffer::MASK] = Event{zone, start_ns, end_ns};
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::name_thread(const std::string& name) {
+        ThreadBuffer& buffer = local_buffer();
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer.name = name;
+    }
+
+    void Profiler::collect() {
+        collecting_.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& buffer : buffers_) collecting_.push_back(buffer.get());
+        }
+        for (uint32_t thread = 0; thread < collecting_.size(); ++thread) {
+            ThreadBuffer& buffer = *collecting_[thread];
+            uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+            uint64_t head = buffer.head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail) {
+                const Event& event = buffer.events[tail & ThreadBuffer::MASK];
+                // Zones registered by other threads since the last collect have no window yet.
+                if (event.zone >= windows_.size()) windows_.resize(event.zone + 1);
+                Window& window = windows_[event.zone];
+                if (window.samples.size() < Constants::PROFILE_WINDOW) window.samples.push_back(event.end_ns - event.start_ns);
+                else window.samples[window.next] = event.end_ns - event.start_ns;
+                window.next = (window.next + 1) % Constants::PROFILE_WINDOW;
+                if (trace_.size() < trace_capacity_) trace_.push_back(TraceEvent{event, thread});
+                else if (trace_capacity_ > 0) ++trace_dropped_;
+            }
+            buffer.tail.store(head, std::memory_order_release);
+        }
+    }
+
+    std::vector<ZoneStats> Profiler::get_stats() const {
+        std::vector<ZoneStats> stats;
+        std::vector<int64_t> sorted;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t zone = 0; zone < windows_.size(); ++zone) {
+            const Window& window = windows_[zone];
+            if (window.samples.empty()) continue;
+            sorted = window.samples;
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&](double p) { return sorted[static_cast<size_t>(p * (sorted.size() - 1))] / 1e6; };
+            stats.push_back(ZoneStats{zone_names_[zone], sorted.size(), percentile(0.5), percentile(0.99), sorted.back() / 1e6});
+        }
+        return stats;
+    }
+
+    uint64_t Profiler::get_dropped() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t dropped = 0;
+        for (const auto& buffer : buffers_) dropped += buffer->dropped.load(std::memory_order_relaxed);
+        return dropped;
+    }
+
+    void Profiler::start_trace(size_t capacity) {
+        trace_.clear();
+        trace_.reserve(std::min<size_t>(capacity, 1 << 16));
+        trace_capacity_ = capacity;
+        trace_dropped_ = 0;
+    }
+
+    bool Profiler::write_trace(const std::string& path) const {
+        std::FILE* out = std::fopen(path.c_str(), "w");
+        if (!out) {
+            LOG_ERROR("Cannot open profile trace", {"path", path});
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::fprintf(out, "{\"traceEvents\":[\n");
+        for (size_t thread = 0; thread < buffers_.size(); ++thread) {
+            std::fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}},\n",
+                         thread, buffers_[thread]->name.c_str());
+        }
+        for (const TraceEvent& trace : trace_) {
+            const Event& event = trace.event;
+            std::fprintf(out, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+                         zone_names_[event.zone], trace.thread, (event.start_ns - start_ns_) / 1e3,
+                         (event.end_ns - event.start_ns) / 1e3);
+        }
+        uint64_t dropped = trace_dropped_;
+        for (const auto& buffer : buffers_) dropped += buffer->dropped.load(std::memory_order_relaxed);
+        // Trailing metadata record keeps every event line comma-terminated.
+        std::fprintf(out, "{\"name\":\"dropped_events\",\"ph\":\"M\",\"pid\":1,\"args\":{\"count\":%llu}}\n]}\n",
+                     static_cast<unsigned long long>(dropped));
+        bool ok = std::ferror(out) == 0;
+        std::fclose(out);
+        return ok;
+    }
+}
@@ -0,0 +1,50 @@
+#include "registry.h"
+#include "constants.h"
+#include <algorithm>
+
+const Registry& Registry::get() {
+    static const Registry registry;
+    return registry;
+}
+
+Registry::Registry() {
+    add_item(Constants::EMPTY);
+    fire_grass = add_item(Constants::FIRE_GRASS);
+    wood_grass = add_item(Constants::WOOD_GRASS);
+    pill = add_item(Constants::PILL);
+
+    low_flame = add_flame(Constants::LOW_FLAME, 0.0);
+    add_flame(Constants::MID_FLAME, Constants::MID_FLAME_BONUS);
+    add_flame(Constants::HIGH_FLAME, Constants::HIGH_FLAME_BONUS);
+
+    recipes_.push_back(RecipeDef{fire_grass, Constants::FIRE_GRASS_REQUIRED, pill, Constants::REFINE_TIME, Constants::BASE_SUCCESS_RATE});
+
+    for (ItemId item = 1; item < items_.size(); ++item) items_by_name_.push_back(item);
+    std::sort(items_by_name_.begin(), items_by_name_.end(), [this](ItemId a, ItemId b) { return items_[a] < items_[b]; });
+}
+
+ItemId Registry::find_item(std::string_view name) const {
+    auto it = item_ids_.find(name);
+    return it != item_ids_.end() ? it->second : INVALID_ITEM;
+}
+
+FlameId Registry::find_flame(std::string_view name) const {
+    for (size_t id = 0; id < flames_.size(); ++id) {
+        if (flames_[id].name == name) return static_cast<FlameId>(id);
+    }
+    return INVALID_FLAME;
+}
+
+ItemId Registry::add_item(const std::string& name) {
+    ItemId id = static_cast<ItemId>(items_.size());
+    items_.push_back(name);
+    item_keys_.push_back(StateHash::name_key(name));
+    item_ids_.emplace(items_.back(), id);
+    return id;
+}
+
+FlameId Registry::add_flame(const std::string& name, double bonus) {
+    flames_.push_back(FlameDef{name, bonus});
+    flame_keys_.push_back(StateHash::name_key(name));
+    return static_cast<FlameId>(flames_.size() - 1);
+}
@@ -1,188 +1,279 @@
 #include "renderer.h"
 #include "constants.h"
-#include <SDL2/SDL_image.h>
-#include <iostream>
+#include "log.h"
+#include "profiler.h"
+#include "timing.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 
-Renderer::Renderer() : window_(nullptr), renderer_(nullptr), font_(nullptr) {}
+namespace {
+    // Whole seconds shown for a running refine.
+    int refine_countdown(const RenderSnapshot& state, int64_t now_ns) {
+        return state.refining ? static_cast<int>(std::ceil(state.refine_seconds_left_at(now_ns))) : 0;
+    }
+}
+
+Renderer::Renderer()
+    : window_(nullptr), renderer_(nullptr), font_(nullptr), fps_(0.0), tps_(0.0), show_profile_(false), drawn_screen_(Screen::FIELD),
+      drawn_revision_(0), drawn_refining_(false), drawn_countdown_(0) {
+    const Registry& registry = Registry::get();
+    for (ItemId item = 0; item < registry.item_count(); ++item) inventory_keys_.push_back("inventory." + registry.item_name(item));
+}
 
 Renderer::~Renderer() {
+    sprites_.clear();
+    text_cache_.clear();
     if (font_) TTF_CloseFont(font_);
     if (renderer_) SDL_DestroyRenderer(renderer_);
     if (window_) SDL_DestroyWindow(window_);
     TTF_Quit();
-    IMG_Quit();
     SDL_Quit();
 }
 
-bool Renderer::init() {
+bool Renderer::init(bool vsync, bool software) {
+    // Everything runs on this thread: SDL, SDL_ttf and SDL_image are not safe
+    // to initialize or use concurrently. SDL_image is not initialized here:
+    // IMG_Load starts the PNG loader itself if an atlas file exists.
+    if (!create_window(vsync, software) || !load_assets()) return false;
+    PROFILE_ZONE("upload_assets");
+    return text_cache_.upload(renderer_) && sprites_.upload(renderer_);
+}
+
+bool Renderer::create_window(bool vsync, bool software) {
+    PROFILE_ZONE("create_window");
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "SDL_Init Error: " << SDL_GetError() << std::endl;
-        return false;
-    }
-    if (TTF_Init() < 0) {
-        std::cerr << "TTF_Init Error: " << TTF_GetError() << std::endl;
-        return false;
-    }
-    if (IMG_Init(IMG_INIT_PNG) == 0) {
-        std::cerr << "IMG_Init Error: " << SDL_GetError() << std::endl;
+        LOG_ERROR("SDL_Init failed", {"error", SDL_GetError()});
         return false;
     }
     window_ = SDL_CreateWindow("Alchemist MVP", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                               Constants::WINDOW_WIDTH, Constants::WINDOW_HEIGHT, 0);
     if (!window_) {
-        std::cerr << "Window Error: " << SDL_GetError() << std::endl;
+        LOG_ERROR("Cannot create window", {"error", SDL_GetError()});
         return false;
     }
-    renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 flags = (software ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED) | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
+    renderer_ = SDL_CreateRenderer(window_, -1, flags);
     if (!renderer_) {
-        std::cerr << "Renderer Error: " << SDL_GetError() << std::endl;
+        LOG_ERROR("Cannot create renderer", {"error", SDL_GetError()});
+        return false;
+    }
+    return true;
+}
+
+// Surfaces only; upload() turns them into textures.
+bool Renderer::load_assets() {
+    PROFILE_ZONE("load_assets");
+    if (TTF_Init() < 0) {
+        LOG_ERROR("TTF_Init failed", {"error", TTF_GetError()});
         return false;
     }
     font_ = TTF_OpenFont(Constants::FONT_PATH.c_str(), Constants::FONT_SIZE);
     if (!font_) {
-        std::cerr << "Font Error: " << TTF_GetError() << std::endl;
+        LOG_ERROR("Cannot open font", {"error", TTF_GetError()});
         return false;
     }
-    return true;
+    return text_cache_.rasterize(font_) && sprites_.load(Constants::SPRITE_ATLAS_PATH);
 }
 
-void Renderer::render(const Game& game, Screen screen) {
+bool Renderer::is_stale(const RenderSnapshot& state, Screen screen) const {
+    return show_profile_ || screen != drawn_screen_ || state.revision != drawn_revision_ || state.refining != drawn_refining_ ||
+           (screen == Screen::REFINING && refine_countdown(state, Timing::now_ns()) != drawn_countdown_);
+}
+
+int64_t Renderer::get_still_ns(const RenderSnapshot& state, Screen screen) const {
+    if (show_profile_) return 0;
+    if (screen != Screen::REFINING || !state.refining) return -1;
+    // Until the countdown drops to its next whole second
+    double left = state.refine_seconds_left_at(Timing::now_ns());
+    double next = std::ceil(left) - 1.0;
+    return next < 0.0 ? -1 : static_cast<int64_t>(std::ceil((left - next) * Constants::NANOSECONDS_PER_SECOND));
+}
+
+void Renderer::render(const RenderSnapshot& state, Screen screen) {
+    PROFILE_ZONE("render");
+    drawn_screen_ = screen;
+    drawn_revision_ = state.revision;
+    drawn_refining_ = state.refining;
+    drawn_countdown_ = refine_countdown(state, Timing::now_ns());
     SDL_SetRenderDrawColor(renderer_, Constants::toSDLColor(Constants::WHITE).r, Constants::toSDLColor(Constants::WHITE).g, Constants::toSDLColor(Constants::WHITE).b, Constants::toSDLColor(Constants::WHITE).a);
     SDL_RenderClear(renderer_);
+    if (show_profile_) profile_stats_ = Profile::Profiler::instance().get_stats();
+
+    // Every rectangle goes out in one batch; text is drawn over it afterwards.
+    {
+        PROFILE_ZONE("render.sprites");
+        if (screen == Screen::FIELD) queue_field_sprites(state);
+        else if (screen == Screen::REFINING) queue_refining_sprites();
+        queue_navigation_sprites(screen);
+        if (show_profile_) sprites_.add(Sprite::PANEL, profile_panel_rect());
+        sprites_.flush();
+    }
 
     switch (screen) {
-        case Screen::FIELD:
-            render_field_screen(game);
+        case Screen::FIELD: {
+            PROFILE_ZONE("render.field");
+            render_field_screen(state);
             break;
-        case Screen::INVENTORY:
-            render_inventory_screen(game);
+        }
+        case Screen::INVENTORY: {
+            PROFILE_ZONE("render.inventory");
+            render_inventory_screen(state);
             break;
-        case Screen::REFINING:
-            render_refining_screen(game);
+        }
+        case Screen::REFINING: {
+            PROFILE_ZONE("render.refining");
+            render_refining_screen(state);
             break;
+        }
     }
 
-    render_navigation_buttons(screen);
+    render_navigation_labels();
+    render_loop_stats();
+    if (show_profile_) render_profile_overlay();
+    PROFILE_ZONE("render.present");
     SDL_RenderPresent(renderer_);
 }
 
-void Renderer::render_field_screen(const Game& game) {
-    for (size_t i = 0; i < game.get_fields().size(); ++i) {
-        int x = (i % Constants::GRID_SIZE) * Constants::FIELD_SPACING + Constants::FIELD_START_X;
-        int y = (i / Constants::GRID_SIZE) * Constants::FIELD_SPACING + Constants::FIELD_START_Y;
-        SDL_Rect rect = {x, y, Constants::FIELD_SIZE, Constants::FIELD_SIZE};
-        if (game.get_fields()[i].is_empty()) {
-            SDL_SetRenderDrawColor(renderer_, Constants::GRAY.r, Constants::GRAY.g, Constants::GRAY.b, Constants::GRAY.a);
-        } else if (game.get_fields()[i].is_ready()) {
-            SDL_SetRenderDrawColor(renderer_, Constants::RED.r, Constants::RED.g, Constants::RED.b, Constants::RED.a);
-        } else {
-            SDL_SetRenderDrawColor(renderer_, Constants::GREEN.r, Constants::GREEN.g, Constants::GREEN.b, Constants::GREEN.a);
+// Plots one by one while they are big enough to see, otherwise one tile per
+// lod_block() square, coloured from the snapshot's block counts. Either way only
+// the part of the grid inside the viewport is visited.
+void Renderer::queue_field_sprites(const RenderSnapshot& state) {
+    const int width = state.width, height = state.height;
+    camera_.clamp(width, height);
+    const Camera::Rect& view = camera_.get_viewport();
+    const SDL_Rect clip = {view.x, view.y, view.w, view.h};
+    const int block = camera_.lod_block();
+    Camera::Range range = camera_.visible(width, height, block);
+    if (block == 1) {
+        for (int row = range.row0; row < range.row1; ++row) {
+            for (int col = range.col0; col < range.col1; ++col) {
+                size_t i = static_cast<size_t>(row) * width + col;
+                Camera::Rect rect = camera_.cell_rect(col, row);
+                sprites_.add(state.is_empty(i) ? Sprite::PLOT_EMPTY : SpriteBatch::crop_sprite(state.get_crop(i), state.is_ready(i)),
+                             SDL_Rect{rect.x, rect.y, rect.w, rect.h}, clip);
+            }
         }
-        SDL_RenderFillRect(renderer_, &rect);
+        return;
     }
+    const int span = block / Constants::FIELD_BLOCK; // Summary blocks per tile side
+    for (int row = range.row0; row < range.row1; ++row) {
+        for (int col = range.col0; col < range.col1; ++col) {
+            int ready = 0, growing = 0, plots = 0;
+            for (int by = row * span; by < std::min((row + 1) * span, state.blocks_high); ++by) {
+                for (int bx = col * span; bx < std::min((col + 1) * span, state.blocks_wide); ++bx) {
+                    size_t b = static_cast<size_t>(by) * state.blocks_wide + bx;
+                    ready += state.get_block_ready(b);
+                    growing += state.get_block_growing(b);
+                    plots += state.get_block_plots(b);
+                }
+            }
+            int empty = plots - ready - growing;
+            Sprite tile = ready >= growing && ready >= empty ? Sprite::TILE_READY : growing >= empty ? Sprite::TILE_GROWING : Sprite::TILE_EMPTY;
+            Camera::Rect rect = camera_.cell_rect(col, row, block);
+            sprites_.add(tile, SDL_Rect{rect.x, rect.y, rect.w, rect.h}, clip);
+        }
+    }
+}
 
-    int y_offset = Constants::INVENTORY_START_Y;
-    for (const auto& [item, count] : game.get_inventory()) {
-        std::string text = item + ": " + std::to_string(count);
-        SDL_Surface* surface = TTF_RenderUTF8_Solid(font_, text.c_str(), Constants::toSDLColor(Constants::WHITE));
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer_, surface);
-        SDL_Rect dst = {Constants::INVENTORY_X, y_offset, 200, Constants::TEXT_HEIGHT};
-        SDL_RenderCopy(renderer_, texture, nullptr, &dst);
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
-        y_offset += Constants::TEXT_HEIGHT;
+void Renderer::queue_refining_sprites() {
+    sprites_.add(Sprite::BUTTON, SDL_Rect{Constants::BUTTON_X, Constants::REFINE_BUTTON_Y, Constants::BUTTON_WIDTH, Constants::BUTTON_HEIGHT});
+    sprites_.add(Sprite::BUTTON_ACTIVE, SDL_Rect{Constants::BUTTON_X, Constants::FLAME_BUTTON_Y, Constants::BUTTON_WIDTH, Constants::BUTTON_HEIGHT});
+}
+
+void Renderer::queue_navigation_sprites(Screen current_screen) {
+    const Screen screens[] = {Screen::FIELD, Screen::INVENTORY, Screen::REFINING};
+    for (int i = 0; i < 3; ++i) {
+        SDL_Rect button = {Constants::WINDOW_WIDTH - 150 + 50 * i, 10, 40, 40};
+        sprites_.add(screens[i] == current_screen ? Sprite::BUTTON_ACTIVE : Sprite::BUTTON, button);
     }
-    std::string flame_text = "Flame: " + game.get_flame_type();
-    SDL_Surface* surface = TTF_RenderUTF8_Solid(font_, flame_text.c_str(), Constants::toSDLColor(Constants::WHITE));
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer_, surface);
+}
+
+void Renderer::render_field_screen(const RenderSnapshot& state) {
+    int y_offset = render_inventory_text(state);
     SDL_Rect dst = {Constants::INVENTORY_X, y_offset, 200, Constants::TEXT_HEIGHT};
-    SDL_RenderCopy(renderer_, texture, nullptr, &dst);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
+    render_flame_label(state, dst);
 }
 
-void Renderer::render_inventory_screen(const Game& game) {
+void Renderer::render_inventory_screen(const RenderSnapshot& state) {
+    render_inventory_text(state);
+}
+
+int Renderer::render_inventory_text(const RenderSnapshot& state) {
     int y_offset = Constants::INVENTORY_START_Y;
-    for (const auto& [item, count] : game.get_inventory()) {
-        std::string text = item + ": " + std::to_string(count);
-        SDL_Surface* surface = TTF_RenderUTF8_Solid(font_, text.c_str(), Constants::toSDLColor(Constants::WHITE));
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer_, surface);
+    const Registry& registry = Registry::get();
+    const Inventory& inventory = state.inventory;
+    for (ItemId item : registry.items_by_name()) {
         SDL_Rect dst = {Constants::INVENTORY_X, y_offset, 200, Constants::TEXT_HEIGHT};
-        SDL_RenderCopy(renderer_, texture, nullptr, &dst);
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
+        char text[64];
+        std::snprintf(text, sizeof(text), "%s: %d", registry.item_name(item).c_str(), inventory.get(item));
+        text_cache_.draw(inventory_keys_[item], text, dst);
         y_offset += Constants::TEXT_HEIGHT;
     }
+    return y_offset;
 }
 
-void Renderer::render_refining_screen(const Game& game) {
-    render_inventory_screen(game); // Include inventory
+void Renderer::render_refining_screen(const RenderSnapshot& state) {
+    render_inventory_screen(state); // Include inventory
 
-    SDL_SetRenderDrawColor(renderer_, Constants::BLUE.r, Constants::BLUE.g, Constants::BLUE.b, Constants::BLUE.a);
-    SDL_Rect button = {Constants::BUTTON_X, Constants::REFINE_BUTTON_Y, Constants::BUTTON_WIDTH, Constants::BUTTON_HEIGHT};
-    SDL_RenderFillRect(renderer_, &button);
-    SDL_Surface* surface = TTF_RenderUTF8_Solid(font_, "Refine", Constants::toSDLColor(Constants::WHITE));
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer_, surface);
     SDL_Rect dst = {Constants::BUTTON_X + 10, Constants::REFINE_BUTTON_Y + 10, Constants::BUTTON_WIDTH - 20, Constants::TEXT_HEIGHT};
-    SDL_RenderCopy(renderer_, texture, nullptr, &dst);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
-
-    SDL_SetRenderDrawColor(renderer_, Constants::CYAN.r, Constants::CYAN.g, Constants::CYAN.b, Constants::CYAN.a);
-    button = {Constants::BUTTON_X, Constants::FLAME_BUTTON_Y, Constants::BUTTON_WIDTH, Constants::BUTTON_HEIGHT};
-    SDL_RenderFillRect(renderer_, &button);
-    surface = TTF_RenderUTF8_Solid(font_, "Toggle Flame", Constants::toSDLColor(Constants::WHITE));
-    texture = SDL_CreateTextureFromSurface(renderer_, surface);
+    text_cache_.draw("button.refine", "Refine", dst);
     dst = {Constants::BUTTON_X + 10, Constants::FLAME_BUTTON_Y + 10, Constants::BUTTON_WIDTH - 20, Constants::TEXT_HEIGHT};
-    SDL_RenderCopy(renderer_, texture, nullptr, &dst);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
+    text_cache_.draw("button.flame", "Toggle Flame", dst);
 
-    std::string flame_text = "Flame: " + game.get_flame_type();
-    surface = TTF_RenderUTF8_Solid(font_, flame_text.c_str(), Constants::toSDLColor(Constants::WHITE));
-    texture = SDL_CreateTextureFromSurface(renderer_, surface);
     dst = {Constants::BUTTON_X, Constants::FLAME_BUTTON_Y + Constants::BUTTON_HEIGHT + 10, 200, Constants::TEXT_HEIGHT};
-    SDL_RenderCopy(renderer_, texture, nullptr, &dst);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
-}
-
-void Renderer::render_navigation_buttons(Screen current_screen) {
-    SDL_SetRenderDrawColor(renderer_, Constants::BLUE.r, Constants::BLUE.g, Constants::BLUE.b, Constants::BLUE.a);
-    SDL_Rect field_button = {Constants::WINDOW_WIDTH - 150, 10, 40, 40};
-    SDL_Rect inv_button = {Constants::WINDOW_WIDTH - 100, 10, 40, 40};
-    SDL_Rect refine_button = {Constants::WINDOW_WIDTH - 50, 10, 40, 40};
-
-    SDL_SetRenderDrawColor(renderer_, current_screen == Screen::FIELD ? Constants::CYAN.r : Constants::BLUE.r,
-                           current_screen == Screen::FIELD ? Constants::CYAN.g : Constants::BLUE.g,
-                           current_screen == Screen::FIELD ? Constants::CYAN.b : Constants::BLUE.b, Constants::BLUE.a);
-    SDL_RenderFillRect(renderer_, &field_button);
-    SDL_Surface* surface = TTF_RenderUTF8_Solid(font_, "Field", Constants::toSDLColor(Constants::WHITE));
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer_, surface);
+    render_flame_label(state, dst);
+    if (state.refining) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "Refining %ds", drawn_countdown_);
+        text_cache_.draw_glyphs(text, Constants::BUTTON_X, dst.y + Constants::TEXT_HEIGHT, Constants::BLUE);
+    }
+}
+
+void Renderer::render_flame_label(const RenderSnapshot& state, const SDL_Rect& dst) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "Flame: %s", Registry::get().flame(state.flame).name.c_str());
+    text_cache_.draw("flame", text, dst);
+}
+
+void Renderer::render_navigation_labels() {
     SDL_Rect dst = {Constants::WINDOW_WIDTH - 145, 15, 30, Constants::TEXT_HEIGHT};
-    SDL_RenderCopy(renderer_, texture, nullptr, &dst);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
-
-    SDL_SetRenderDrawColor(renderer_, current_screen == Screen::INVENTORY ? Constants::CYAN.r : Constants::BLUE.r,
-                           current_screen == Screen::INVENTORY ? Constants::CYAN.g : Constants::BLUE.g,
-                           current_screen == Screen::INVENTORY ? Constants::CYAN.b : Constants::BLUE.b, Constants::BLUE.a);
-    SDL_RenderFillRect(renderer_, &inv_button);
-    surface = TTF_RenderUTF8_Solid(font_, "Inv", Constants::toSDLColor(Constants::WHITE));
-    texture = SDL_CreateTextureFromSurface(renderer_, surface);
+    text_cache_.draw("nav.field", "Field", dst);
     dst = {Constants::WINDOW_WIDTH - 95, 15, 30, Constants::TEXT_HEIGHT};
-    SDL_RenderCopy(renderer_, texture, nullptr, &dst);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
-
-    SDL_SetRenderDrawColor(renderer_, current_screen == Screen::REFINING ? Constants::CYAN.r : Constants::BLUE.r,
-                           current_screen == Screen::REFINING ? Constants::CYAN.g : Constants::BLUE.g,
-                           current_screen == Screen::REFINING ? Constants::CYAN.b : Constants::BLUE.b, Constants::BLUE.a);
-    SDL_RenderFillRect(renderer_, &refine_button);
-    surface = TTF_RenderUTF8_Solid(font_, "Refine", Constants::toSDLColor(Constants::WHITE));
-    texture = SDL_CreateTextureFromSurface(renderer_, surface);
+    text_cache_.draw("nav.inventory", "Inv", dst);
     dst = {Constants::WINDOW_WIDTH - 45, 15, 30, Constants::TEXT_HEIGHT};
-    SDL_RenderCopy(renderer_, texture, nullptr, &dst);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
-}
\ No newline at end of file
+    text_cache_.draw("nav.refine", "Refine", dst);
+}
+
+void Renderer::render_loop_stats() {
+    char text[64];
+    std::snprintf(text, sizeof(text), "FPS %.0f  TPS %.0f", fps_, tps_);
+    text_cache_.draw_glyphs(text, Constants::STATS_X, Constants::STATS_Y, Constants::BLUE);
+}
+
+SDL_Rect Renderer::profile_panel_rect() const {
+    int line = text_cache_.glyph_height();
+    int rows = static_cast<int>(profile_stats_.size()) + 2; // Header, zones, sprite batch
+    return SDL_Rect{Constants::PROFILE_OVERLAY_X, Constants::PROFILE_OVERLAY_Y - (rows - 1) * line, 380, rows * line};
+}
+
+// Per-zone frame timings over the profiler's recent window, toggled with F3.
+void Renderer::render_profile_overlay() {
+    int line = text_cache_.glyph_height();
+    int y = profile_panel_rect().y;
+    char text[96];
+    if (!ALCHEMIST_PROFILE) {
+        text_cache_.draw_glyphs("profiler compiled out", Constants::PROFILE_OVERLAY_X, y, Constants::BLUE);
+        return;
+    }
+    std::snprintf(text, sizeof(text), "%-16s %7s %7s %7s", "zone (ms)", "p50", "p99", "max");
+    text_cache_.draw_glyphs(text, Constants::PROFILE_OVERLAY_X, y, Constants::BLUE);
+    for (const auto& zone : profile_stats_) {
+        y += line;
+        std::snprintf(text, sizeof(text), "%-16s %7.2f %7.2f %7.2f", zone.name.c_str(), zone.p50_ms, zone.p99_ms, zone.max_ms);
+        text_cache_.draw_glyphs(text, Constants::PROFILE_OVERLAY_X, y, Constants::BLUE);
+    }
+    std::snprintf(text, sizeof(text), "sprites %zu in %d draw call%s", sprites_.get_last_sprites(), sprites_.get_last_draw_calls(),
+                  sprites_.get_last_draw_calls() == 1 ? "" : "s");
+    text_cache_.draw_glyphs(text, Constants::PROFILE_OVERLAY_X, y + line, Constants::BLUE);
+}
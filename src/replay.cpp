@@ -0,0 +1,163 @@
+#include "replay.h"
+#include "log.h"
+#include "savemanager.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+namespace {
+    const char* const REPLAY_MAGIC = "alchemist-replay";
+    constexpr int REPLAY_VERSION = 1;
+    const char* const COMMAND_NAMES[] = {"plant", "harvest", "refine", "flame"};
+    constexpr size_t MIN_COMMAND_BYTES = 8; // Four fields of at least one character, with separators
+
+    bool parse_command_type(const std::string& name, CommandType& type) {
+        for (int i = 0; i < 4; ++i) {
+            if (name == COMMAND_NAMES[i]) {
+                type = static_cast<CommandType>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Names, not ids, go into the file so logs survive registry changes.
+    std::string id_name(const Command& command) {
+        const Registry& registry = Registry::get();
+        if (command.type == CommandType::PLANT) return registry.item_name(command.id);
+        if (command.type == CommandType::SET_FLAME) return registry.flame(static_cast<FlameId>(command.id)).name;
+        return "-";
+    }
+
+    bool parse_id(const std::string& name, Command& command) {
+        const Registry& registry = Registry::get();
+        command.id = 0;
+        if (command.type == CommandType::PLANT) {
+            command.id = registry.find_item(name);
+            return command.id != Registry::INVALID_ITEM;
+        }
+        if (command.type == CommandType::SET_FLAME) {
+            FlameId flame = registry.find_flame(name);
+            command.id = flame;
+            return flame != Registry::INVALID_FLAME;
+        }
+        return true;
+    }
+}
+
+bool execute_command(Game& game, const Command& command) {
+    switch (command.type) {
+        case CommandType::PLANT:
+            return game.plant(command.index, command.id);
+        case CommandType::HARVEST: {
+            ItemId harvested;
+            return game.harvest(command.index, harvested);
+        }
+        case CommandType::START_REFINING:
+            return game.start_refining();
+        case CommandType::SET_FLAME:
+            if (command.id >= Registry::get().flame_count()) return false;
+            game.set_flame_type(static_cast<FlameId>(command.id));
+            return true;
+    }
+    return false;
+}
+
+CommandLog::CommandLog() : tick_dt_(0.0), end_tick_(0) {}
+
+void CommandLog::begin(const Game& game, double tick_dt) {
+    snapshot_ = SaveManager::serialize(game);
+    tick_dt_ = tick_dt;
+    end_tick_ = 0;
+    commands_.clear();
+}
+
+bool CommandLog::execute(Game& game, const Command& command) {
+    if (!execute_command(game, command)) return false;
+    commands_.push_back(command);
+    return true;
+}
+
+bool CommandLog::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LOG_ERROR("Cannot open replay for writing", {"path", path});
+        return false;
+    }
+    file << REPLAY_MAGIC << ' ' << REPLAY_VERSION << '\n'
+         << "dt " << std::setprecision(std::numeric_limits<double>::max_digits10) << tick_dt_ << '\n'
+         << "end " << end_tick_ << '\n'
+         << "snapshot " << snapshot_.size() << '\n';
+    file.write(snapshot_.data(), static_cast<std::streamsize>(snapshot_.size()));
+    file << "\ncommands " << commands_.size() << '\n';
+    for (const auto& command : commands_) {
+        file << command.tick << ' ' << COMMAND_NAMES[static_cast<int>(command.type)] << ' ' << command.index << ' '
+             << id_name(command) << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+bool CommandLog::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Cannot open replay", {"path", path});
+        return false;
+    }
+    file.seekg(0, std::ios::end);
+    const std::streamoff file_size = file.tellg();
+    file.seekg(0);
+    // Sizes come from the file, so they are checked against what is left of
+    // it before anything is allocated for them.
+    auto remaining = [&file, file_size] { return static_cast<size_t>(std::max<std::streamoff>(file_size - file.tellg(), 0)); };
+    std::string magic, dt_key, end_key, snapshot_key, commands_key;
+    int version = 0;
+    size_t snapshot_size = 0, command_count = 0;
+    file >> magic >> version;
+    if (magic != REPLAY_MAGIC || version != REPLAY_VERSION) {
+        LOG_ERROR("Not a replay of this version", {"path", path}, {"version", REPLAY_VERSION});
+        return false;
+    }
+    file >> dt_key >> tick_dt_ >> end_key >> end_tick_ >> snapshot_key >> snapshot_size;
+    file.ignore(1); // Newline before the raw snapshot
+    if (!file || dt_key != "dt" || end_key != "end" || snapshot_key != "snapshot" || snapshot_size > remaining()) {
+        LOG_ERROR("Replay has a corrupt header", {"path", path});
+        return false;
+    }
+    snapshot_.assign(snapshot_size, '\0');
+    file.read(snapshot_.data(), static_cast<std::streamsize>(snapshot_size));
+    file >> commands_key >> command_count;
+    if (!file || commands_key != "commands" || command_count > remaining() / MIN_COMMAND_BYTES) {
+        LOG_ERROR("Replay has a corrupt command count", {"path", path});
+        return false;
+    }
+    commands_.clear();
+    commands_.reserve(command_count);
+    for (size_t i = 0; i < command_count && file; ++i) {
+        Command command{0, CommandType::PLANT, 0, 0};
+        std::string name, arg;
+        file >> command.tick >> name >> command.index >> arg;
+        if (!parse_command_type(name, command.type) || !parse_id(arg, command)) {
+            LOG_ERROR("Bad command in replay", {"path", path}, {"command", name}, {"id", arg});
+            return false;
+        }
+        commands_.push_back(command);
+    }
+    if (!file) {
+        LOG_ERROR("Replay is truncated", {"path", path});
+        return false;
+    }
+    return true;
+}
+
+bool CommandLog::replay(Game& game) const {
+    if (!SaveManager::deserialize(snapshot_, game)) return false;
+    size_t next = 0;
+    for (int64_t tick = 0; tick <= end_tick_; ++tick) {
+        while (next < commands_.size() && commands_[next].tick == tick) {
+            execute_command(game, commands_[next++]);
+        }
+        if (tick < end_tick_) game.update(tick_dt_);
+    }
+    return next == commands_.size();
+}
@@ -0,0 +1,57 @@
+#include "rng.h"
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+    uint64_t splitmix64(uint64_t& x) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+}
+
+Rng::Rng(uint64_t seed) {
+    this->seed(seed);
+}
+
+void Rng::seed(uint64_t seed) {
+    seed_ = seed;
+    uint64_t x = seed;
+    for (auto& word : state_) word = splitmix64(x);
+}
+
+uint64_t Rng::next_geometric(double p) {
+    if (p >= 1.0) return 0;
+    if (p <= 0.0) return std::numeric_limits<uint64_t>::max();
+    // Inverse CDF; 1 - u is in (0, 1] so the log is finite.
+    double failures = std::floor(std::log(1.0 - next_double()) / std::log1p(-p));
+    return failures >= 1.8e19 ? std::numeric_limits<uint64_t>::max() : static_cast<uint64_t>(failures);
+}
+
+void Rng::fill_bernoulli(uint64_t* words, size_t bits, double p) {
+    size_t word_count = (bits + 63) / 64;
+    if (p <= 0.0 || p >= 1.0) {
+        uint64_t fill = p >= 1.0 ? ~uint64_t(0) : 0;
+        for (size_t w = 0; w < word_count; ++w) words[w] = fill;
+    } else {
+        // Two 32-bit samples per draw; 2^-32 resolution is plenty for game odds.
+        const uint64_t threshold = static_cast<uint64_t>(p * 4294967296.0);
+        for (size_t w = 0; w < word_count; ++w) {
+            uint64_t word = 0;
+            for (int b = 0; b < 64; b += 2) {
+                uint64_t r = next_u64();
+                word |= static_cast<uint64_t>((r & 0xffffffffULL) < threshold) << b;
+                word |= static_cast<uint64_t>((r >> 32) < threshold) << (b + 1);
+            }
+            words[w] = word;
+        }
+    }
+    if (bits % 64) words[word_count - 1] &= (uint64_t(1) << (bits % 64)) - 1;
+}
+
+uint64_t Rng::random_seed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+}
@@ -1,56 +1,505 @@
 #include "savemanager.h"
+#include "binarysave.h"
+#include "jsonwriter.h"
 #include "constants.h"
+#include "journal.h"
+#include "log.h"
+#include "timing.h"
 #include <fstream>
-#include <iostream>
+#include <filesystem>
+#include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
-void SaveManager::load(Game& game) {
-    std::ifstream file(Constants::SAVE_FILE);
-    if (file.is_open()) {
-        try {
-            json j;
-            file >> j;
-            std::cout << "Loading save.json..." << std::endl;
-            game = Game(); // Reset to default state
-            for (const auto& f : j["fields"]) {
-                int idx = j["fields"].size();
-                if (idx < Constants::FIELD_COUNT) {
-                    std::string type = f.contains("type") && !f["type"].is_null() ? f["type"].get<std::string>() : Constants::EMPTY;
-                    double growth_time = f.contains("growth_time") && !f["growth_time"].is_null() ? f["growth_time"].get<double>() : Constants::DEFAULT_GROWTH_TIME;
-                    game.plant(idx, type);
-                    if (f.contains("ready") && !f["ready"].is_null() && f["ready"].get<bool>()) {
-                        game.get_fields()[idx].update(growth_time); // Simulate growth to ready
-                    }
-                }
+namespace {
+
+// A save whose rebuilt state hashes differently from what was written was
+// damaged or hand-edited, or names something this build no longer has. The
+// load goes ahead with what could be read, but it is worth knowing about.
+void check_state_hash(const Game& game, uint64_t saved, const char* format) {
+    if (game.get_state_hash() == saved) return;
+    LOG_WARN("Save state hash mismatch, loaded state differs from what was saved", {"format", format},
+             {"saved", saved}, {"loaded", game.get_state_hash()});
+}
+
+}
+
+SaveFormat SaveManager::format_for(const std::string& path) {
+    const std::string& suffix = Constants::BINARY_SAVE_SUFFIX;
+    bool binary = path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    return binary ? SaveFormat::BINARY : SaveFormat::JSON;
+}
+
+bool SaveManager::read(const std::string& path, Game& game, int64_t& saved_at_ms) {
+    saved_at_ms = 0;
+    BinarySave::MappedFile file;
+    if (!file.open(path)) return false;
+    if (BinarySave::is_binary(file.data(), file.size())) {
+        // Current files are read straight from the mapping; older ones are upgraded in a copy.
+        std::vector<uint8_t> migrated;
+        const uint8_t* data = file.data();
+        size_t size = file.size();
+        std::string error;
+        if (BinarySave::needs_migration(data, size)) {
+            migrated.assign(data, data + size);
+            if (!BinarySave::migrate(migrated, error)) {
+                LOG_WARN("Cannot migrate binary save", {"path", path}, {"error", error});
+                return false;
             }
-            game = Game();
-            game.get_inventory() = j.contains("inventory") && !j["inventory"].is_null() ?
-                                   j["inventory"].get<std::map<std::string, int>>() :
-                                   Constants::DEFAULT_INVENTORY;
-            game.set_proficiency(j.contains("proficiency") && !j["proficiency"].is_null() ? j["proficiency"].get<int>() : 0);
-            game.set_flame_type(j.contains("flame_type") && !j["flame_type"].is_null() ? j["flame_type"].get<std::string>() : Constants::LOW_FLAME);
-            std::cout << "Loaded game: flame_type=" << game.get_flame_type() << ", fields=" << game.get_fields().size() << std::endl;
-        } catch (const json::exception& e) {
-            std::cerr << "JSON Load Error: " << e.what() << std::endl;
-            std::cout << "Creating new game state due to JSON error" << std::endl;
-            game = Game();
-        }
-    } else {
-        std::cout << "No save.json found, creating new game state" << std::endl;
+            data = migrated.data();
+            size = migrated.size();
+        }
+        BinarySave::View view;
+        if (!view.open(data, size, error)) {
+            LOG_WARN("Invalid binary save", {"path", path}, {"error", error});
+            return false;
+        }
+        view.apply(game);
+        saved_at_ms = view.state().saved_at;
+        if (view.state().state_hash != 0) check_state_hash(game, view.state().state_hash, "binary");
+        return true;
+    }
+    return deserialize(std::string_view(reinterpret_cast<const char*>(file.data()), file.size()), game, &saved_at_ms);
+}
+
+void SaveManager::load(Game& game, const std::string& path) {
+    if (!std::filesystem::exists(path)) {
+        LOG_INFO("No save found, creating new game state", {"path", path});
+        game = Game();
+        return;
+    }
+    LOG_INFO("Loading save", {"path", path});
+    int64_t saved_at_ms;
+    if (!read(path, game, saved_at_ms)) {
+        LOG_WARN("Creating new game state due to an unreadable save");
         game = Game();
+        return;
     }
+    GameTime snapshot_time = game.get_time();
+    Journal::recover(path, game); // Commands written after the snapshot
+    if (saved_at_ms != 0) {
+        // Offline time is wall time since the snapshot minus the play the journal replayed.
+        double offline = (Timing::unix_ms() - saved_at_ms) / 1000.0 - to_seconds(game.get_time() - snapshot_time);
+        if (offline > 0) {
+            uint64_t attacks = game.get_stats().pest_attacks;
+            int64_t begin = Timing::now_ns();
+            game.advance(offline);
+            LOG_INFO("Fast-forwarded offline time", {"seconds", offline}, {"pest_attacks", game.get_stats().pest_attacks - attacks},
+                     {"us", (Timing::now_ns() - begin) / 1000});
+        }
+    }
+    LOG_INFO("Loaded game", {"flame_type", game.get_flame_name()}, {"fields", game.get_fields().size()});
 }
 
-void SaveManager::save(const Game& game) {
-    json j;
-    j["fields"] = json::array();
-    for (const auto& f : game.get_fields()) {
-        j["fields"].push_back({{"type", f.get_type()}, {"growth_time", Constants::DEFAULT_GROWTH_TIME}, {"ready", f.is_ready()}});
+bool SaveManager::convert(const std::string& from_path, const std::string& to_path) {
+    Game game;
+    int64_t saved_at_ms;
+    if (!read(from_path, game, saved_at_ms)) {
+        LOG_ERROR("Cannot read save to convert", {"path", from_path});
+        return false;
+    }
+    return write_atomic(to_path, encode(game, to_path, saved_at_ms));
+}
+
+void SaveManager::encode(const Game& game, const std::string& path, int64_t saved_at_ms, std::string& out) {
+    if (format_for(path) == SaveFormat::BINARY) BinarySave::encode(game, saved_at_ms, out);
+    else serialize(game, saved_at_ms, out);
+}
+
+std::string SaveManager::encode(const Game& game, const std::string& path, int64_t saved_at_ms) {
+    std::string out;
+    encode(game, path, saved_at_ms, out);
+    return out;
+}
+
+namespace {
+
+// Values the reader collects before it can build the Game: dump() sorts keys,
+// so "fields" arrives before the grid size and seed it depends on.
+struct FieldEntry {
+    ItemId crop = Registry::EMPTY_ITEM;
+    double growth_time = Constants::DEFAULT_GROWTH_TIME;
+    bool ready = false;
+    bool has_ready_at = false;
+    GameTime ready_at = 0;
+};
+
+struct SaveData {
+    int64_t width = Constants::GRID_SIZE; // Checked against MAX_FARM_SIDE before use
+    int64_t height = Constants::GRID_SIZE;
+    bool has_seed = false;
+    uint64_t seed = 0;
+    Rng::State rng{};
+    size_t rng_count = 0;
+    bool rng_valid = false;
+    GameTime time = 0;
+    std::vector<FieldEntry> fields;
+    std::vector<int> inventory = std::vector<int>(Registry::get().item_count(), 0);
+    bool refining = false;
+    size_t refine_recipe = 0;
+    bool has_refine_done_at = false;
+    GameTime refine_done_at = 0;
+    int proficiency = 0;
+    FlameId flame = Registry::get().low_flame;
+    int64_t saved_at = 0;
+    bool has_state_hash = false;
+    uint64_t state_hash = 0;
+};
+
+// SAX handler that fills SaveData as the parser walks save.json, without
+// building a DOM. Nulls read as absent and unknown keys are skipped, as the
+// schema has always allowed; a value of the wrong type fails the load.
+class SaveReader : public json::json_sax_t {
+public:
+    explicit SaveReader(SaveData& data) : data_(data) {}
+
+    bool null() override { return scalar(Scalar{Scalar::NUL}); }
+    bool boolean(bool value) override {
+        Scalar s{Scalar::BOOL};
+        s.b = value;
+        return scalar(s);
+    }
+    bool number_integer(number_integer_t value) override { return number(value, static_cast<double>(value)); }
+    bool number_unsigned(number_unsigned_t value) override { return number(static_cast<int64_t>(value), static_cast<double>(value)); }
+    bool number_float(number_float_t value, const string_t&) override { return number(static_cast<int64_t>(value), value); }
+    bool string(string_t& value) override {
+        Scalar s{Scalar::STRING};
+        s.s = value;
+        return scalar(s);
+    }
+    bool binary(binary_t&) override { return mismatch(); }
+    bool start_object(size_t) override { return open(false); }
+    bool start_array(size_t) override { return open(true); }
+    bool end_object() override { return close(); }
+    bool end_array() override { return close(); }
+    bool key(string_t& name) override {
+        if (depth_ == 1) top_ = top_key(name);
+        else if (depth_ == 2 && in_container_) item_ = name;
+        else if (depth_ == 3 && in_container_ && field_object_) field_key_ = field_key(name);
+        return true;
+    }
+    bool parse_error(size_t, const std::string&, const nlohmann::detail::exception& e) override {
+        LOG_WARN("Cannot parse JSON save", {"error", e.what()});
+        return false;
+    }
+
+private:
+    enum class Top { OTHER, FIELDS, WIDTH, HEIGHT, TIME, SAVED_AT, SEED, RNG_STATE, INVENTORY, PROFICIENCY, REFINING, REFINE_RECIPE, REFINE_DONE_AT, FLAME_TYPE, STATE_HASH };
+    enum class FieldKey { OTHER, TYPE, GROWTH_TIME, READY, READY_AT };
+
+    struct Scalar {
+        enum Kind { NUL, BOOL, NUMBER, STRING } kind;
+        explicit Scalar(Kind k) : kind(k) {}
+        bool b = false;
+        int64_t i = 0;
+        double d = 0.0;
+        std::string_view s;
+    };
+
+    static Top top_key(std::string_view name) {
+        static const std::pair<std::string_view, Top> KEYS[] = {
+            {"fields", Top::FIELDS}, {"width", Top::WIDTH}, {"height", Top::HEIGHT}, {"time", Top::TIME}, {"saved_at", Top::SAVED_AT},
+            {"seed", Top::SEED}, {"rng_state", Top::RNG_STATE}, {"inventory", Top::INVENTORY}, {"proficiency", Top::PROFICIENCY},
+            {"refining", Top::REFINING}, {"refine_recipe", Top::REFINE_RECIPE}, {"refine_done_at", Top::REFINE_DONE_AT}, {"flame_type", Top::FLAME_TYPE},
+            {"state_hash", Top::STATE_HASH}};
+        for (const auto& [key, top] : KEYS) {
+            if (key == name) return top;
+        }
+        return Top::OTHER;
+    }
+
+    static FieldKey field_key(std::string_view name) {
+        if (name == "type") return FieldKey::TYPE;
+        if (name == "growth_time") return FieldKey::GROWTH_TIME;
+        if (name == "ready") return FieldKey::READY;
+        if (name == "ready_at") return FieldKey::READY_AT;
+        return FieldKey::OTHER;
+    }
+
+    bool number(int64_t i, double d) {
+        Scalar s{Scalar::NUMBER};
+        s.i = i;
+        s.d = d;
+        return scalar(s);
+    }
+
+    bool mismatch() {
+        LOG_WARN("Unexpected value type in JSON save");
+        return false;
+    }
+
+    bool open(bool array) {
+        if (depth_ == 1) {
+            // Only these members are read as containers; other nested values are skipped whole.
+            in_container_ = (top_ == Top::FIELDS && array) || (top_ == Top::RNG_STATE && array) || (top_ == Top::INVENTORY && !array);
+            if (in_container_ && top_ == Top::FIELDS) data_.fields.clear();
+            if (in_container_ && top_ == Top::RNG_STATE) data_.rng_count = 0;
+        } else if (depth_ == 2 && in_container_) {
+            if (top_ != Top::FIELDS) return mismatch(); // Counters and rng words are plain numbers
+            data_.fields.emplace_back(); // Entries that are not objects read as empty plots
+            field_key_ = FieldKey::OTHER;
+            field_object_ = !array;
+        }
+        ++depth_;
+        return true;
+    }
+
+    bool close() {
+        --depth_;
+        if (depth_ == 1 && in_container_ && top_ == Top::RNG_STATE) data_.rng_valid = data_.rng_count == data_.rng.size();
+        if (depth_ == 1) in_container_ = false;
+        return true;
+    }
+
+    bool scalar(const Scalar& v) {
+        if (depth_ == 1) return top_value(v);
+        if (depth_ == 2 && in_container_) {
+            if (top_ == Top::FIELDS) {
+                data_.fields.emplace_back(); // A non-object entry reads as an empty plot
+                return true;
+            }
+            if (top_ == Top::RNG_STATE) {
+                if (v.kind != Scalar::NUMBER) return mismatch();
+                if (data_.rng_count < data_.rng.size()) data_.rng[data_.rng_count] = static_cast<uint64_t>(v.i);
+                ++data_.rng_count;
+                return true;
+            }
+            return inventory_value(v);
+        }
+        if (depth_ == 3 && in_container_ && field_object_) return field_value(v);
+        return true;
+    }
+
+    bool inventory_value(const Scalar& v) {
+        if (v.kind != Scalar::NUMBER) return mismatch();
+        ItemId item = Registry::get().find_item(item_);
+        if (item == Registry::INVALID_ITEM || item == Registry::EMPTY_ITEM) {
+            LOG_WARN("Unknown item in save ignored", {"item", item_});
+            return true;
+        }
+        data_.inventory[item] = static_cast<int>(v.i);
+        return true;
+    }
+
+    bool field_value(const Scalar& v) {
+        if (v.kind == Scalar::NUL) return true;
+        FieldEntry& field = data_.fields.back();
+        switch (field_key_) {
+            case FieldKey::TYPE:
+                if (v.kind != Scalar::STRING) return mismatch();
+                field.crop = Registry::get().find_item(v.s);
+                if (field.crop == Registry::INVALID_ITEM) {
+                    LOG_WARN("Unknown crop in save, field left empty", {"type", v.s}, {"field", data_.fields.size() - 1});
+                }
+                break;
+            case FieldKey::GROWTH_TIME:
+                if (v.kind != Scalar::NUMBER) return mismatch();
+                field.growth_time = v.d;
+                break;
+            case FieldKey::READY:
+                if (v.kind != Scalar::BOOL) return mismatch();
+                field.ready = v.b;
+                break;
+            case FieldKey::READY_AT:
+                if (v.kind != Scalar::NUMBER) return mismatch();
+                field.has_ready_at = true;
+                field.ready_at = v.i;
+                break;
+            case FieldKey::OTHER:
+                break;
+        }
+        return true;
+    }
+
+    bool top_value(const Scalar& v) {
+        if (v.kind == Scalar::NUL) return true;
+        switch (top_) {
+            case Top::OTHER:
+            case Top::FIELDS:
+            case Top::RNG_STATE:
+            case Top::INVENTORY:
+                return true; // Not the container the schema expects; ignored
+            case Top::REFINING:
+                if (v.kind != Scalar::BOOL) return mismatch();
+                data_.refining = v.b;
+                return true;
+            case Top::FLAME_TYPE: {
+                if (v.kind != Scalar::STRING) return mismatch();
+                FlameId flame = Registry::get().find_flame(v.s);
+                data_.flame = flame != Registry::INVALID_FLAME ? flame : Registry::get().low_flame;
+                return true;
+            }
+            default:
+                break;
+        }
+        if (v.kind != Scalar::NUMBER) return mismatch();
+        switch (top_) {
+            case Top::WIDTH: data_.width = v.i; break;
+            case Top::HEIGHT: data_.height = v.i; break;
+            case Top::TIME: data_.time = v.i; break;
+            case Top::SAVED_AT: data_.saved_at = v.i; break;
+            case Top::SEED:
+                data_.has_seed = true;
+                data_.seed = static_cast<uint64_t>(v.i);
+                break;
+            case Top::PROFICIENCY: data_.proficiency = static_cast<int>(v.i); break;
+            case Top::REFINE_RECIPE: data_.refine_recipe = static_cast<size_t>(v.i); break;
+            case Top::REFINE_DONE_AT:
+                data_.has_refine_done_at = true;
+                data_.refine_done_at = v.i;
+                break;
+            case Top::STATE_HASH:
+                data_.has_state_hash = true;
+                data_.state_hash = static_cast<uint64_t>(v.i);
+                break;
+            default: break;
+        }
+        return true;
+    }
+
+    SaveData& data_;
+    size_t depth_ = 0;
+    Top top_ = Top::OTHER;
+    bool in_container_ = false;
+    bool field_object_ = false;
+    FieldKey field_key_ = FieldKey::OTHER;
+    std::string item_; // Current inventory key; keeps its capacity between keys
+};
+
+void apply(const SaveData& data, Game& game) {
+    uint64_t seed = data.has_seed ? data.seed : Rng::random_seed();
+    game = Game(static_cast<int>(data.width), static_cast<int>(data.height), seed); // Reset to default state
+    if (data.rng_valid) game.set_rng_state(seed, data.rng);
+    game.set_time(data.time);
+    for (size_t idx = 0; idx < data.fields.size(); ++idx) {
+        const FieldEntry& f = data.fields[idx];
+        if (f.crop == Registry::INVALID_ITEM) continue;
+        // Saves written before the virtual clock restart growth from the load time.
+        GameTime ready_at = f.has_ready_at ? f.ready_at : game.get_time() + to_game_time(f.growth_time);
+        game.restore_field(static_cast<int>(idx), f.crop, ready_at, f.ready);
+    }
+    for (ItemId item = 1; item < data.inventory.size(); ++item) game.restore_item_count(item, data.inventory[item]);
+    if (data.refining) game.restore_refining(data.refine_recipe, data.has_refine_done_at ? data.refine_done_at : game.get_time());
+    game.set_proficiency(data.proficiency);
+    game.set_flame_type(data.flame);
+}
+
+}
+
+bool SaveManager::deserialize(std::string_view data, Game& game, int64_t* saved_at_ms) {
+    SaveData save;
+    SaveReader reader(save);
+    if (!json::sax_parse(data.begin(), data.end(), &reader)) return false;
+    if (save.width <= 0 || save.height <= 0 || save.width > Constants::MAX_FARM_SIDE || save.height > Constants::MAX_FARM_SIDE) {
+        LOG_WARN("Save has an unsupported farm size", {"width", save.width}, {"height", save.height});
+        return false;
+    }
+    if (save.fields.size() != static_cast<uint64_t>(save.width * save.height)) {
+        LOG_WARN("Save plot count does not match its farm size", {"fields", save.fields.size()}, {"width", save.width},
+                 {"height", save.height});
+        return false;
+    }
+    apply(save, game);
+    if (save.has_state_hash) check_state_hash(game, save.state_hash, "json");
+    if (saved_at_ms) *saved_at_ms = save.saved_at;
+    return true;
+}
+
+bool SaveManager::save(const Game& game, const std::string& path) {
+    std::string data;
+    encode(game, path, Timing::unix_ms(), data);
+    return write_atomic(path, data);
+}
+
+std::string SaveManager::serialize(const Game& game, int64_t saved_at_ms) {
+    std::string out;
+    serialize(game, saved_at_ms, out);
+    return out;
+}
+
+void SaveManager::serialize(const Game& game, int64_t saved_at_ms, std::string& out) {
+    const Registry& registry = Registry::get();
+    const FieldStore& fields = game.get_fields();
+    out.clear();
+    out.reserve(fields.size() * Constants::SAVE_FIELD_JSON_BYTES + 1024);
+    // Members go out in key order, as dump() wrote them from the old DOM.
+    JsonWriter w(out);
+    w.begin_object();
+    w.key("fields");
+    w.begin_array();
+    for (size_t i = 0; i < fields.size(); ++i) {
+        GameTime ready_at = fields.get_ready_at(i);
+        w.begin_object();
+        w.key("growth_time");
+        w.value(Constants::DEFAULT_GROWTH_TIME);
+        w.key("ready");
+        w.value(fields.is_ready(i));
+        w.key("ready_at");
+        w.value(ready_at);
+        w.key("type");
+        w.value(registry.item_name(fields.get_crop(i)));
+        w.end_object();
+    }
+    w.end_array();
+    w.key("flame_type");
+    w.value(game.get_flame_name());
+    w.key("height");
+    w.value(fields.get_height());
+    w.key("inventory");
+    w.begin_object();
+    for (ItemId item : registry.items_by_name()) { // Name order, as dump() gave the inventory object
+        w.key(registry.item_name(item));
+        w.value(game.get_inventory().get(item));
+    }
+    w.end_object();
+    w.key("proficiency");
+    w.value(game.get_proficiency());
+    if (game.is_refining()) {
+        w.key("refine_done_at");
+        w.value(game.get_refine_done_at());
+        w.key("refine_recipe");
+        w.value(game.get_refine_recipe());
+    }
+    w.key("refining");
+    w.value(game.is_refining());
+    w.key("rng_state");
+    w.begin_array();
+    for (uint64_t word : game.get_rng().get_state()) w.value(word);
+    w.end_array();
+    if (saved_at_ms != 0) {
+        w.key("saved_at");
+        w.value(saved_at_ms);
+    }
+    w.key("seed");
+    w.value(game.get_rng().get_seed());
+    w.key("state_hash");
+    w.value(game.get_state_hash());
+    w.key("time");
+    w.value(game.get_time());
+    w.key("width");
+    w.value(fields.get_width());
+    w.end_object();
+}
+
+bool SaveManager::write_atomic(const std::string& path, const std::string& data) {
+    std::string temp_path = path + Constants::SAVE_TEMP_SUFFIX;
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("Cannot open save for writing", {"path", temp_path});
+            return false;
+        }
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            LOG_ERROR("Save write failed", {"path", temp_path});
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        LOG_ERROR("Save rename failed", {"path", path}, {"error", ec.message()});
+        return false;
     }
-    j["inventory"] = game.get_inventory();
-    j["proficiency"] = game.get_proficiency();
-    j["flame_type"] = game.get_flame_type();
-    std::ofstream file(Constants::SAVE_FILE);
-    file << j.dump(Constants::JSON_INDENT);
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "saveservice.h"
+#include "savemanager.h"
+#include "log.h"
+#include "profiler.h"
+#include "timing.h"
+
+SaveService::SaveService(const std::string& path, double interval, size_t capacity)
+    : path_(path), interval_(interval), capacity_(capacity > 0 ? capacity : 1), queued_revision_(0),
+      write_failed_(false), writing_(false), stopping_(false) {}
+
+SaveService::~SaveService() {
+    stop();
+}
+
+void SaveService::start(const Game& game) {
+    if (worker_.joinable()) return;
+    queued_revision_ = game.get_revision();
+    write_failed_ = false;
+    last_submit_ = std::chrono::steady_clock::now();
+    stopping_ = false;
+    worker_ = std::thread(&SaveService::run, this);
+}
+
+bool SaveService::is_dirty(const Game& game) {
+    // A failed write saved nothing, so whatever it carried is queued again.
+    if (write_failed_.exchange(false, std::memory_order_acq_rel)) queued_revision_ = NOT_QUEUED;
+    return game.get_revision() != queued_revision_;
+}
+
+bool SaveService::poll(const Game& game, bool force) {
+    if (!is_dirty(game)) return false;
+    auto now = std::chrono::steady_clock::now();
+    if (!force && std::chrono::duration<double>(now - last_submit_).count() < interval_) return false;
+    submit(game);
+    last_submit_ = now;
+    return true;
+}
+
+void SaveService::flush(const Game& game) {
+    if (!worker_.joinable()) {
+        if (is_dirty(game) && SaveManager::write_atomic(path_, SaveManager::encode(game, path_, Timing::unix_ms()))) {
+            queued_revision_ = game.get_revision();
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.last_revision = queued_revision_;
+        }
+        return;
+    }
+    if (is_dirty(game)) submit(game);
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] { return queue_.empty() && !writing_; });
+}
+
+void SaveService::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!worker_.joinable()) return;
+        stopping_ = true;
+    }
+    queue_cv_.notify_all();
+    worker_.join();
+    SaveStats stats = get_stats();
+    LOG_INFO("Save service stopped", {"saves", stats.saves_written}, {"bytes", stats.bytes_written},
+             {"avg_latency_ms", stats.saves_written ? stats.total_latency_ms / stats.saves_written : 0.0},
+             {"max_latency_ms", stats.max_latency_ms});
+}
+
+SaveStats SaveService::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void SaveService::submit(const Game& game) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= capacity_) {
+            queue_.back() = game;
+            ++stats_.snapshots_coalesced;
+        } else {
+            queue_.push_back(game);
+        }
+    }
+    queued_revision_ = game.get_revision();
+    queue_cv_.notify_one();
+}
+
+void SaveService::run() {
+    Profile::Profiler::instance().name_thread("save");
+    std::string data; // Reused across writes so steady-state saves do not allocate it
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        queue_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) break; // Stopping with nothing left to write
+        // Only the newest snapshot matters; older queued ones are superseded.
+        stats_.snapshots_coalesced += queue_.size() - 1;
+        Game snapshot = std::move(queue_.back());
+        queue_.clear();
+        writing_ = true;
+        lock.unlock();
+
+        auto begin = std::chrono::steady_clock::now();
+        bool ok;
+        {
+            PROFILE_ZONE("save.write");
+            SaveManager::encode(snapshot, path_, Timing::unix_ms(), data);
+            ok = SaveManager::write_atomic(path_, data);
+        }
+        double latency_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        lock.lock();
+        writing_ = false;
+        if (ok) {
+            ++stats_.saves_written;
+            stats_.bytes_written += data.size();
+            stats_.last_revision = snapshot.get_revision();
+            stats_.last_latency_ms = latency_ms;
+            stats_.total_latency_ms += latency_ms;
+            if (latency_ms > stats_.max_latency_ms) stats_.max_latency_ms = latency_ms;
+        } else {
+            ++stats_.saves_failed;
+            write_failed_.store(true, std::memory_order_release);
+        }
+        if (queue_.empty()) idle_cv_.notify_all();
+    }
+    writing_ = false;
+    idle_cv_.notify_all();
+}
@@ -0,0 +1,41 @@
+#include "scheduler.h"
+#include <algorithm>
+
+namespace {
+    int rank(EventType type) {
+        switch (type) {
+            case EventType::FIELD_READY: return 0;
+            case EventType::PEST_CHECK:
+            case EventType::PEST_ATTACK: return 1;
+            case EventType::REFINE_DONE: return 2;
+        }
+        return 3;
+    }
+
+    // std heap functions build a max-heap, so order by "later than".
+    bool later(const ScheduledEvent& a, const ScheduledEvent& b) {
+        if (a.due != b.due) return a.due > b.due;
+        if (a.type != b.type) return rank(a.type) > rank(b.type);
+        if (a.target != b.target) return a.target > b.target;
+        return a.seq > b.seq;
+    }
+}
+
+Scheduler::Scheduler() : next_seq_(0) {}
+
+void Scheduler::schedule(GameTime due, EventType type, int32_t target) {
+    heap_.push_back(ScheduledEvent{due, next_seq_++, type, target});
+    std::push_heap(heap_.begin(), heap_.end(), later);
+}
+
+bool Scheduler::pop_due(GameTime now, ScheduledEvent& event) {
+    if (heap_.empty() || heap_.front().due > now) return false;
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    event = heap_.back();
+    heap_.pop_back();
+    return true;
+}
+
+void Scheduler::clear() {
+    heap_.clear();
+}
@@ -0,0 +1,268 @@
+// Headless batch simulator: runs many independent farms for a stretch of
+// virtual time as fast as the CPU allows and prints aggregate balance stats.
+#include "farmhost.h"
+#include "game.h"
+#include "constants.h"
+#include "timing.h"
+#include "replay.h"
+#include "savemanager.h"
+#include "log.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct SimOptions {
+    int farms = 100;
+    int width = Constants::GRID_SIZE;
+    int height = Constants::GRID_SIZE;
+    double hours = 24.0;
+    double tick_rate = Constants::TICK_RATE;
+    double policy_interval = 1.0; // Virtual seconds between player actions
+    std::string plant = Constants::FIRE_GRASS; // Crop to plant, or "none"
+    bool harvest = true;
+    bool refine = true;
+    std::string flame = Constants::LOW_FLAME;
+    bool verbose = false;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool scaling = false;         // Repeat the run at 1, 2, 4, ... threads
+    bool seeded = false;
+    uint64_t seed = 0;            // Farm i uses seed + i
+    std::string replay_path;      // Replay a recorded input log instead of simulating
+    std::string convert_from;     // Convert a save file instead of simulating
+    std::string convert_to;
+};
+
+void print_usage() {
+    std::cout << "Usage: alchemist_sim [options]\n"
+              << "  --farms N              number of independent farms (default 100)\n"
+              << "  --size WxH             plots per farm (default " << Constants::GRID_SIZE << "x" << Constants::GRID_SIZE << ")\n"
+              << "  --hours H              virtual hours to simulate per farm (default 24)\n"
+              << "  --tick-rate R          simulation ticks per virtual second (default " << Constants::TICK_RATE << ")\n"
+              << "  --policy-interval S    virtual seconds between player actions (default 1)\n"
+              << "  --plant CROP|none      crop planted into every empty field (default fire_grass)\n"
+              << "  --harvest auto|never   harvest ready fields\n"
+              << "  --refine auto|never    start refining whenever enough fire_grass is stored\n"
+              << "  --flame low|mid|high   flame used for refining\n"
+              << "  --seed S               seed farm i with S + i for reproducible runs\n"
+              << "  --threads N            worker threads advancing the farms (default: all cores)\n"
+              << "  --scaling              repeat the run at 1, 2, 4, ... N threads and report efficiency\n"
+              << "  --replay FILE          replay an input log recorded with alchemist --record\n"
+              << "  --convert IN OUT       rewrite a save file; OUT ending in " << Constants::BINARY_SAVE_SUFFIX << " is binary, else JSON\n"
+              << "  --verbose              print game events (as compiled in by ALCHEMIST_LOG_LEVEL)\n";
+}
+
+bool parse_options(int argc, char* argv[], SimOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--farms" && has_value) options.farms = std::atoi(argv[++i]);
+        else if (arg == "--size" && has_value) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) {
+                LOG_ERROR("--size expects WxH");
+                return false;
+            }
+        }
+        else if (arg == "--hours" && has_value) options.hours = std::atof(argv[++i]);
+        else if (arg == "--tick-rate" && has_value) options.tick_rate = std::atof(argv[++i]);
+        else if (arg == "--policy-interval" && has_value) options.policy_interval = std::atof(argv[++i]);
+        else if (arg == "--plant" && has_value) options.plant = argv[++i];
+        else if (arg == "--harvest" && has_value) options.harvest = std::strcmp(argv[++i], "never") != 0;
+        else if (arg == "--refine" && has_value) options.refine = std::strcmp(argv[++i], "never") != 0;
+        else if (arg == "--flame" && has_value) options.flame = argv[++i];
+        else if (arg == "--seed" && has_value) {
+            options.seeded = true;
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--threads" && has_value) options.threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--scaling") options.scaling = true;
+        else if (arg == "--replay" && has_value) options.replay_path = argv[++i];
+        else if (arg == "--convert" && i + 2 < argc) {
+            options.convert_from = argv[++i];
+            options.convert_to = argv[++i];
+        }
+        else if (arg == "--verbose") options.verbose = true;
+        else {
+            print_usage();
+            return false;
+        }
+    }
+    if (options.farms <= 0 || options.width <= 0 || options.height <= 0 || options.hours <= 0 || options.tick_rate <= 0 || options.threads == 0) {
+        LOG_ERROR("Farms, size, hours, tick rate and threads must be positive");
+        return false;
+    }
+    if (Registry::get().find_flame(options.flame) == Registry::INVALID_FLAME) {
+        LOG_ERROR("Unknown flame", {"flame", options.flame});
+        return false;
+    }
+    if (options.plant != "none" && Registry::get().find_item(options.plant) == Registry::INVALID_ITEM) {
+        LOG_ERROR("Unknown crop", {"crop", options.plant});
+        return false;
+    }
+    return true;
+}
+
+// Policy settings resolved to registry ids once, before the hot loop.
+struct Policy {
+    ItemId crop; // EMPTY_ITEM plants nothing
+    bool harvest;
+    bool refine;
+};
+
+void apply_policy(Game& game, const Policy& policy) {
+    const FieldStore& fields = game.get_fields();
+    ItemId harvested;
+    if (policy.harvest) {
+        for (size_t i = fields.next_ready(0); i != FieldStore::NPOS; i = fields.next_ready(i + 1)) {
+            game.harvest(static_cast<int>(i), harvested);
+        }
+    }
+    if (policy.crop != Registry::EMPTY_ITEM) {
+        for (size_t i = fields.next_empty(0); i != FieldStore::NPOS; i = fields.next_empty(i + 1)) {
+            if (!game.plant(static_cast<int>(i), policy.crop)) break;
+        }
+    }
+    if (policy.refine && game.can_refine()) {
+        game.start_refining();
+    }
+}
+
+// FNV-1a over the serialized state: equal digests mean identical outcomes.
+uint64_t state_digest(const Game& game) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : SaveManager::serialize(game)) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+int run_replay(const SimOptions& options) {
+    CommandLog log;
+    if (!log.load(options.replay_path)) return 1;
+    Game game;
+    bool complete = log.replay(game);
+    Log::Logger::instance().stop();
+    std::cout << "Replayed " << log.size() << " commands over " << log.get_end_tick() << " ticks"
+              << (complete ? "" : " (some commands were past the end tick)") << "\n"
+              << "  pills:       " << game.get_inventory().get(Registry::get().pill) << "\n"
+              << "  proficiency: " << game.get_proficiency() << "\n"
+              << "  digest:      " << std::hex << state_digest(game) << "\n"
+              << "  state hash:  " << game.get_state_hash() << std::dec << std::endl;
+    return complete ? 0 : 1;
+}
+
+struct RunResult {
+    double wall_seconds = 0.0;
+    GameStats total;
+    uint64_t pills = 0;
+    size_t threads = 0;
+    size_t chunk_size = 0;
+    uint64_t steals = 0;
+    FarmTickStats ticks;
+};
+
+// Advances every farm tick by tick on a FarmHost; results do not depend on the
+// thread count because farms are independent and seeded up front.
+RunResult run_farms(const SimOptions& options, size_t threads) {
+    FixedTimestep timestep(options.tick_rate);
+    const double dt = timestep.get_dt();
+    const int64_t total_ticks = static_cast<int64_t>(options.hours * 3600.0 * options.tick_rate);
+    const int64_t policy_ticks = std::max<int64_t>(1, static_cast<int64_t>(options.policy_interval * options.tick_rate));
+
+    FarmHost host(threads);
+    for (int i = 0; i < options.farms; ++i) {
+        host.add_farm(options.width, options.height, options.seeded ? options.seed + i : Rng::random_seed());
+    }
+    const Registry& registry = Registry::get();
+    const Policy policy{options.plant == "none" ? Registry::EMPTY_ITEM : registry.find_item(options.plant), options.harvest, options.refine};
+    for (size_t i = 0; i < host.size(); ++i) host.farm(i).set_flame_type(registry.find_flame(options.flame));
+    const std::function<void(Game&)> act = [&policy](Game& farm) { apply_policy(farm, policy); };
+
+    int64_t begin = Timing::now_ns();
+    for (int64_t tick = 0; tick < total_ticks; ++tick) {
+        if (tick % policy_ticks == 0) host.tick(dt, act);
+        else host.tick(dt);
+    }
+
+    RunResult result;
+    result.wall_seconds = (Timing::now_ns() - begin) / Constants::NANOSECONDS_PER_SECOND;
+    for (size_t i = 0; i < host.size(); ++i) {
+        const GameStats& stats = host.farm(i).get_stats();
+        result.total.plants += stats.plants;
+        result.total.harvests += stats.harvests;
+        result.total.refines_started += stats.refines_started;
+        result.total.refines_succeeded += stats.refines_succeeded;
+        result.total.refines_failed += stats.refines_failed;
+        result.total.pest_attacks += stats.pest_attacks;
+        result.total.fields_lost += stats.fields_lost;
+        result.pills += host.farm(i).get_inventory().get(registry.pill);
+    }
+    result.threads = host.get_threads();
+    result.chunk_size = host.get_chunk_size();
+    result.steals = host.get_steals();
+    result.ticks = host.get_tick_stats();
+    return result;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    SimOptions options;
+    if (!parse_options(argc, argv, options)) return 1;
+    if (options.verbose) Log::Logger::instance().start();
+    if (!options.replay_path.empty()) return run_replay(options);
+    if (!options.convert_from.empty()) {
+        bool ok = SaveManager::convert(options.convert_from, options.convert_to);
+        Log::Logger::instance().stop();
+        if (ok) std::cout << "Converted " << options.convert_from << " to " << options.convert_to << std::endl;
+        return ok ? 0 : 1;
+    }
+
+    if (options.scaling) {
+        std::vector<size_t> thread_counts;
+        for (size_t threads = 1; threads < options.threads; threads *= 2) thread_counts.push_back(threads);
+        thread_counts.push_back(options.threads);
+        double base_seconds = 0.0;
+        std::cout << "threads  wall s    ms/tick   speedup  efficiency\n";
+        for (size_t threads : thread_counts) {
+            RunResult result = run_farms(options, threads);
+            if (threads == 1) base_seconds = result.wall_seconds;
+            double speedup = result.wall_seconds > 0 ? base_seconds / result.wall_seconds : 0.0;
+            std::printf("%7zu  %8.3f  %8.4f  %7.2f  %9.1f %%\n", threads, result.wall_seconds,
+                        result.ticks.total_ns / 1e6 / std::max<uint64_t>(1, result.ticks.ticks), speedup, 100.0 * speedup / threads);
+        }
+        Log::Logger::instance().stop();
+        return 0;
+    }
+
+    RunResult result = run_farms(options, options.threads);
+    const GameStats& total = result.total;
+    const double wall_seconds = result.wall_seconds;
+    const uint64_t pills = result.pills;
+
+    Log::Logger::instance().stop();
+    double farm_hours = options.farms * options.hours;
+    uint64_t refines_done = total.refines_succeeded + total.refines_failed;
+    std::cout << "Simulated " << options.farms << " farms x " << options.hours << " h (" << farm_hours
+              << " farm-hours) in " << wall_seconds << " s wall time\n"
+              << "  speed:             " << (wall_seconds > 0 ? farm_hours * 3600.0 / wall_seconds : 0.0) << "x real time\n"
+              << "  threads:           " << result.threads << " (chunks of " << result.chunk_size << " farms, " << result.steals << " steals)\n"
+              << "  tick wall time:    " << result.ticks.total_ns / 1e3 / std::max<uint64_t>(1, result.ticks.ticks) << " us mean, "
+              << result.ticks.max_ns / 1e3 << " us max\n"
+              << "  plants:            " << total.plants << "\n"
+              << "  harvests:          " << total.harvests << "\n"
+              << "  refines:           " << refines_done << " (" << total.refines_succeeded << " succeeded)\n"
+              << "  refine success:    " << (refines_done ? 100.0 * total.refines_succeeded / refines_done : 0.0) << " %\n"
+              << "  pills:             " << pills << "\n"
+              << "  pills per hour:    " << pills / farm_hours << " per farm\n"
+              << "  pest attacks:      " << total.pest_attacks << " (" << total.fields_lost << " fields lost)\n"
+              << "  harvest loss rate: " << (total.plants ? 100.0 * total.fields_lost / total.plants : 0.0) << " %"
+              << std::endl;
+    return 0;
+}
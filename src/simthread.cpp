@@ -0,0 +1,130 @@
+#include "simthread.h"
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+
+SimThread::SimThread(Game& game, Journal& journal, SaveService& save_service, double tick_rate, CommandLog* command_log)
+    : game_(game), journal_(journal), save_service_(save_service), command_log_(command_log), tick_rate_(tick_rate),
+      tick_count_(0), measured_tick_rate_(0.0), adaptive_(false), uncapped_ticks_(0), published_(false),
+      published_revision_(0), published_refining_(false), running_(false), wake_(0) {}
+
+SimThread::~SimThread() {
+    stop();
+}
+
+void SimThread::start() {
+    if (thread_.joinable()) return;
+    publish(); // The renderer has a snapshot before the first tick
+    snapshots_.update();
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&SimThread::run, this);
+}
+
+void SimThread::stop() {
+    running_.store(false, std::memory_order_release);
+    wake_.release();
+    if (thread_.joinable()) thread_.join();
+}
+
+bool SimThread::send(const Action& action) {
+    if (!actions_.push(action)) return false;
+    wake_.release();
+    return true;
+}
+
+void SimThread::run() {
+    Profile::Profiler::instance().name_thread("sim");
+    FixedTimestep timestep(tick_rate_);
+    FrameLimiter limiter(tick_rate_);
+    RateCounter tick_counter;
+    int64_t last_time = Timing::now_ns();
+    bool slept = false;
+    while (running_.load(std::memory_order_acquire)) {
+        PROFILE_ZONE("sim");
+        int64_t now = Timing::now_ns();
+        int64_t elapsed = now - last_time;
+        last_time = now;
+
+        int64_t ticks = uncapped_ticks_ > 0 ? uncapped_ticks_ : slept ? timestep.advance_all(elapsed) : timestep.advance(elapsed);
+        // After a sleep the clock catches up first, so whatever woke the thread
+        // lands on the tick it arrived in rather than the one it fell asleep on.
+        if (slept) run_ticks(ticks, timestep.get_dt());
+        while (wake_.try_acquire()) {}
+        Action action;
+        while (actions_.pop(action)) apply(action);
+        if (!slept) run_ticks(ticks, timestep.get_dt());
+        journal_.observe(game_);
+        tick_counter.add(now, ticks);
+        measured_tick_rate_ = tick_counter.get_rate();
+        publish();
+        {
+            PROFILE_ZONE("save");
+            if (save_service_.poll(game_, journal_.get_segment_bytes() > Constants::JOURNAL_COMPACT_BYTES)) journal_.rotate(game_);
+            journal_.retire(save_service_.get_stats().last_revision);
+        }
+        if (uncapped_ticks_ > 0) continue;
+        int64_t idle = adaptive_ ? idle_ns(timestep) : 0;
+        slept = idle > timestep.get_step_ns();
+        if (slept) {
+            PROFILE_ZONE("idle");
+            wake_.try_acquire_for(std::chrono::nanoseconds(idle));
+        } else {
+            limiter.wait();
+        }
+    }
+}
+
+void SimThread::run_ticks(int64_t count, double dt) {
+    PROFILE_ZONE("update");
+    for (int64_t i = 0; i < count; ++i) {
+        game_.update(dt);
+        ++tick_count_;
+    }
+}
+
+// Real time until the tick that reaches the game's next visible event.
+int64_t SimThread::idle_ns(const FixedTimestep& timestep) const {
+    GameTime ahead = std::min(game_.next_wake_time() - game_.get_time(), to_game_time(Constants::IDLE_MAX_SLEEP));
+    int64_t step = timestep.get_step_ns();
+    int64_t ticks = (std::max<GameTime>(ahead, 0) + step - 1) / step;
+    return ticks * step - timestep.get_pending_ns();
+}
+
+void SimThread::apply(const Action& action) {
+    const Registry& registry = Registry::get();
+    switch (action.type) {
+        case ActionType::TAP_PLOT:
+            // An empty plot is planted, a ready one harvested
+            if (!run_command(CommandType::PLANT, action.index, registry.fire_grass)) run_command(CommandType::HARVEST, action.index);
+            break;
+        case ActionType::START_REFINING:
+            run_command(CommandType::START_REFINING);
+            break;
+        case ActionType::NEXT_FLAME:
+            run_command(CommandType::SET_FLAME, 0, registry.next_flame(game_.get_flame_type()));
+            break;
+    }
+}
+
+bool SimThread::run_command(CommandType type, int index, uint16_t id) {
+    Command command{tick_count_, type, index, id};
+    bool changed = command_log_ ? command_log_->execute(game_, command) : execute_command(game_, command);
+    if (changed) journal_.record(game_, command);
+    return changed;
+}
+
+void SimThread::publish() {
+    PROFILE_ZONE("sim.publish");
+    RenderSnapshot& snapshot = snapshots_.back();
+    snapshot.capture(game_);
+    snapshot.tick = tick_count_;
+    snapshot.tick_rate = measured_tick_rate_;
+    // Against the last published snapshot, not the last one in this slot,
+    // so one change wakes the renderer once rather than once per buffer.
+    bool changed = !published_ || snapshot.revision != published_revision_ || snapshot.refining != published_refining_;
+    published_ = true;
+    published_revision_ = snapshot.revision;
+    published_refining_ = snapshot.refining;
+    snapshots_.publish();
+    if (changed && on_change_) on_change_();
+}
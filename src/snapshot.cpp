@@ -0,0 +1,56 @@
+#include "snapshot.h"
+#include "timing.h"
+#include <algorithm>
+
+void RenderSnapshot::capture(const Game& game) {
+    const FieldStore& fields = game.get_fields();
+    bool fresh = field_id != fields.get_id();
+    if (fresh || field_version > fields.get_version()) {
+        // Start over from an empty field, which is what every block that was
+        // never changed still holds.
+        width = fields.get_width();
+        height = fields.get_height();
+        blocks_wide = fields.blocks_wide();
+        blocks_high = fields.blocks_high();
+        plots.assign(fields.size(), 0);
+        block_ready.assign(static_cast<size_t>(blocks_wide) * blocks_high, 0);
+        block_growing.assign(block_ready.size(), 0);
+        field_id = fields.get_id();
+        field_version = 0;
+    }
+    if (field_version != fields.get_version()) {
+        for (size_t b = 0; b < block_ready.size(); ++b) {
+            if (fields.block_version(b) <= field_version) continue;
+            block_ready[b] = static_cast<uint16_t>(fields.block_ready(b));
+            block_growing[b] = static_cast<uint16_t>(fields.block_growing(b));
+            int x0 = static_cast<int>(b % blocks_wide) * Constants::FIELD_BLOCK;
+            int y0 = static_cast<int>(b / blocks_wide) * Constants::FIELD_BLOCK;
+            int x1 = std::min(x0 + Constants::FIELD_BLOCK, width), y1 = std::min(y0 + Constants::FIELD_BLOCK, height);
+            for (int y = y0; y < y1; ++y) {
+                for (size_t i = static_cast<size_t>(y) * width + x0, row_end = i + (x1 - x0); i < row_end; ++i) {
+                    plots[i] = fields.is_empty(i) ? 0 : static_cast<uint16_t>(fields.get_crop(i) << 1 | (fields.is_ready(i) ? 1 : 0));
+                }
+            }
+        }
+        field_version = fields.get_version();
+    }
+    if (fresh || revision != game.get_revision()) {
+        inventory = game.get_inventory();
+        flame = game.get_flame_type();
+        revision = game.get_revision();
+    }
+    refining = game.is_refining();
+    refine_seconds_left = refining ? std::max(0.0, to_seconds(game.get_refine_done_at() - game.get_time())) : 0.0;
+    captured_ns = Timing::now_ns();
+}
+
+double RenderSnapshot::refine_seconds_left_at(int64_t now_ns) const {
+    return std::max(0.0, refine_seconds_left - static_cast<double>(now_ns - captured_ns) / Constants::NANOSECONDS_PER_SECOND);
+}
+
+int RenderSnapshot::get_block_plots(size_t block) const {
+    int bx = static_cast<int>(block % blocks_wide), by = static_cast<int>(block / blocks_wide);
+    int w = std::min(Constants::FIELD_BLOCK, width - bx * Constants::FIELD_BLOCK);
+    int h = std::min(Constants::FIELD_BLOCK, height - by * Constants::FIELD_BLOCK);
+    return w * h;
+}
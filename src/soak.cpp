@@ -0,0 +1,390 @@
+// Soak test for the whole client: runs the real game loop (input, simulation
+// thread, renderer, journal and saves) on SDL's dummy video driver with the
+// software renderer, feeds it scripted input (clicks, zooming and panning) at
+// uncapped speed for hours of virtual play on a farm of any size, and prints
+// frame-time percentiles, memory, allocations and save churn as JSON.
+#include "client.h"
+#include "alloccount.h"
+#include "camera.h"
+#include "constants.h"
+#include "rng.h"
+#include "savemanager.h"
+#include "timing.h"
+#include "log.h"
+#include <SDL2/SDL.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+
+struct SoakOptions {
+    double hours = 1.0;               // Virtual play time
+    uint64_t seed = 1;                // Game and input script
+    int width = 256;                  // Farm size; large enough that zooming out reaches the LOD tiles
+    int height = 256;
+    double inputs_per_minute = 20.0;  // Of virtual time, for generated scripts
+    int ticks_per_step = 60;          // Simulation ticks between snapshots
+    std::string script_path;          // Replay this input instead of generating it
+    std::string write_script_path;    // Save the input used, to replay the run later
+    std::string out_path;
+};
+
+// One scripted input, due once the simulation reaches tick.
+struct Input {
+    enum Kind { CLICK, WHEEL, DRAG, KEY };
+    int64_t tick;
+    Kind kind;
+    int x;     // CLICK, WHEEL: window position; DRAG: pixels moved
+    int y;
+    int value; // WHEEL: notches, positive zooms in; KEY: index into KEYS
+};
+
+// The field screen's keys and the pan each applies, as the client handles them.
+struct KeyDef {
+    const char* name;
+    SDL_Keycode code;
+    double dx, dy;
+};
+constexpr KeyDef KEYS[] = {{"left", SDLK_LEFT, Constants::CAMERA_PAN_STEP, 0},
+                           {"right", SDLK_RIGHT, -Constants::CAMERA_PAN_STEP, 0},
+                           {"up", SDLK_UP, 0, Constants::CAMERA_PAN_STEP},
+                           {"down", SDLK_DOWN, 0, -Constants::CAMERA_PAN_STEP},
+                           {"home", SDLK_HOME, 0, 0}};
+constexpr int HOME_KEY = 4;
+const char* const KIND_NAMES[] = {"click", "wheel", "drag", "key"};
+
+// Random play over every control: plots (planting or harvesting), the camera
+// (wheel zoom, right-drag, arrow keys, Home), refine, flame toggle and the
+// navigation buttons, which are clicked first whenever the next control is on
+// another screen. The generator moves its own Camera exactly as the client
+// moves the real one, so each plot click lands on a plot in view at whatever
+// zoom the view is at, and plots anywhere on the farm get played.
+std::vector<Input> generate_script(const SoakOptions& options, int64_t end_tick) {
+    enum { FIELD, INVENTORY, REFINING };
+    auto nav = [](int screen) { return std::pair<int, int>{Constants::WINDOW_WIDTH - 150 + 50 * screen + 20, 30}; };
+    Camera camera; // The default view the client starts with
+    camera.clamp(options.width, options.height);
+    const Camera::Rect view = camera.get_viewport();
+    Rng rng(options.seed);
+    auto pick = [&rng](int lo, int hi) { return lo + static_cast<int>(rng.next_u64() % static_cast<uint64_t>(hi - lo)); };
+    double mean_gap = Constants::TICK_RATE * 60.0 / std::max(options.inputs_per_minute, 1e-3);
+    std::vector<Input> script;
+    int screen = FIELD;
+    for (int64_t tick = 0;;) {
+        tick += 1 + static_cast<int64_t>(rng.next_geometric(1.0 / mean_gap));
+        if (tick >= end_tick) break;
+        double roll = rng.next_double();
+        int target = roll < 0.75 ? FIELD : roll < 0.92 ? REFINING : pick(0, 3);
+        if (target != screen) {
+            auto [x, y] = nav(target);
+            script.push_back(Input{tick, Input::CLICK, x, y, 0});
+            screen = target;
+        }
+        if (roll < 0.55) {
+            Camera::Range range = camera.visible(options.width, options.height);
+            if (range.col1 <= range.col0 || range.row1 <= range.row0) continue;
+            Camera::Rect rect = camera.cell_rect(pick(range.col0, range.col1), pick(range.row0, range.row1));
+            // Plots at the edge of the view may be only partly inside it.
+            int x = std::clamp(rect.x + rect.w / 2, view.x, view.x + view.w - 1);
+            int y = std::clamp(rect.y + rect.h / 2, view.y, view.y + view.h - 1);
+            script.push_back(Input{tick, Input::CLICK, x, y, 0});
+        } else if (roll < 0.75) {
+            double move = rng.next_double();
+            if (move < 0.4) {
+                int x = pick(view.x, view.x + view.w), y = pick(view.y, view.y + view.h);
+                int notches = pick(1, 4) * (rng.next_double() < 0.5 ? -1 : 1);
+                camera.zoom_at(std::pow(Constants::CAMERA_ZOOM_STEP, notches), x, y);
+                script.push_back(Input{tick, Input::WHEEL, x, y, notches});
+            } else if (move < 0.8) {
+                int dx = pick(-200, 201), dy = pick(-200, 201);
+                camera.pan(dx, dy);
+                script.push_back(Input{tick, Input::DRAG, dx, dy, 0});
+            } else {
+                int key = move < 0.97 ? pick(0, HOME_KEY) : HOME_KEY;
+                if (key == HOME_KEY) camera.reset();
+                else camera.pan(KEYS[key].dx, KEYS[key].dy);
+                script.push_back(Input{tick, Input::KEY, 0, 0, key});
+            }
+            camera.clamp(options.width, options.height);
+        } else if (roll < 0.92) {
+            int y = roll < 0.82 ? Constants::REFINE_BUTTON_Y : Constants::FLAME_BUTTON_Y;
+            script.push_back(Input{tick, Input::CLICK, Constants::BUTTON_X + Constants::BUTTON_WIDTH / 2, y + Constants::BUTTON_HEIGHT / 2, 0});
+        }
+    }
+    return script;
+}
+
+// One input per line: "tick click x y", "tick wheel x y notches", "tick drag
+// dx dy" or "tick key left|right|up|down|home". Blank lines and lines
+// starting with # are skipped.
+bool load_script(const std::string& path, std::vector<Input>& script) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        long long tick;
+        char kind[16], key[16];
+        if (std::sscanf(line.c_str(), "%lld %15s", &tick, kind) != 2) return false;
+        Input input{tick, Input::CLICK, 0, 0, 0};
+        std::string_view name(kind);
+        bool ok = false;
+        if (name == "click") {
+            ok = std::sscanf(line.c_str(), "%*d %*s %d %d", &input.x, &input.y) == 2;
+        } else if (name == "wheel") {
+            input.kind = Input::WHEEL;
+            ok = std::sscanf(line.c_str(), "%*d %*s %d %d %d", &input.x, &input.y, &input.value) == 3;
+        } else if (name == "drag") {
+            input.kind = Input::DRAG;
+            ok = std::sscanf(line.c_str(), "%*d %*s %d %d", &input.x, &input.y) == 2;
+        } else if (name == "key" && std::sscanf(line.c_str(), "%*d %*s %15s", key) == 1) {
+            input.kind = Input::KEY;
+            for (int k = 0; k <= HOME_KEY; ++k) {
+                if (std::string_view(KEYS[k].name) == key) {
+                    input.value = k;
+                    ok = true;
+                }
+            }
+        }
+        if (!ok) return false;
+        script.push_back(input);
+    }
+    std::stable_sort(script.begin(), script.end(), [](const Input& a, const Input& b) { return a.tick < b.tick; });
+    return true;
+}
+
+bool save_script(const std::string& path, const std::vector<Input>& script) {
+    std::ofstream file(path);
+    file << "# tick click x y | tick wheel x y notches | tick drag dx dy | tick key name\n";
+    for (const Input& input : script) {
+        file << input.tick << ' ' << KIND_NAMES[input.kind];
+        if (input.kind == Input::KEY) file << ' ' << KEYS[input.value].name;
+        else file << ' ' << input.x << ' ' << input.y;
+        if (input.kind == Input::WHEEL) file << ' ' << input.value;
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+// Turns an input into the SDL events a player would cause.
+void push_input(const Input& input, const Camera::Rect& view) {
+    SDL_Event event{};
+    switch (input.kind) {
+        case Input::CLICK:
+            event.type = SDL_MOUSEBUTTONDOWN;
+            event.button.button = SDL_BUTTON_LEFT;
+            event.button.state = SDL_PRESSED;
+            event.button.clicks = 1;
+            event.button.x = input.x;
+            event.button.y = input.y;
+            break;
+        case Input::WHEEL: {
+            SDL_Event motion{}; // The wheel zooms about the pointer
+            motion.type = SDL_MOUSEMOTION;
+            motion.motion.x = input.x;
+            motion.motion.y = input.y;
+            SDL_PushEvent(&motion);
+            event.type = SDL_MOUSEWHEEL;
+            event.wheel.y = input.value;
+            break;
+        }
+        case Input::DRAG:
+            event.type = SDL_MOUSEMOTION;
+            event.motion.state = SDL_BUTTON_RMASK;
+            event.motion.x = view.x + view.w / 2;
+            event.motion.y = view.y + view.h / 2;
+            event.motion.xrel = input.x;
+            event.motion.yrel = input.y;
+            break;
+        case Input::KEY:
+            event.type = SDL_KEYDOWN;
+            event.key.state = SDL_PRESSED;
+            event.key.keysym.sym = KEYS[input.value].code;
+            break;
+    }
+    SDL_PushEvent(&event);
+}
+
+uint64_t peak_rss_bytes() {
+#ifndef _WIN32
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+// Frame times in fixed microsecond buckets, so hours of frames take constant
+// memory and recording one never allocates (which would skew the counts).
+class FrameHistogram {
+public:
+    FrameHistogram() : buckets_(BUCKETS, 0), count_(0), max_ns_(0) {}
+    void add(int64_t ns) {
+        ++buckets_[std::min<size_t>(static_cast<size_t>(std::max<int64_t>(ns, 0) / 1000), BUCKETS - 1)];
+        ++count_;
+        max_ns_ = std::max(max_ns_, ns);
+    }
+    uint64_t count() const { return count_; }
+    double max_ms() const { return static_cast<double>(max_ns_) / 1e6; }
+    // Nearest-rank percentile, to the bucket's upper edge.
+    double percentile_ms(double q) const {
+        if (count_ == 0) return 0.0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count_ - 1)) + 1, seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) return std::min(static_cast<double>(i + 1) / 1e3, max_ms());
+        }
+        return max_ms();
+    }
+
+private:
+    static constexpr size_t BUCKETS = 100000; // 1 us each up to 100 ms; slower frames share the last
+    std::vector<uint64_t> buckets_;
+    uint64_t count_;
+    int64_t max_ns_;
+};
+
+void print_usage() {
+    std::cout << "Usage: alchemist_soak [options]\n"
+              << "  --hours H              virtual hours of play (default 1)\n"
+              << "  --seed N               game and input script seed (default 1)\n"
+              << "  --size WxH             plots on the farm (default 256x256)\n"
+              << "  --inputs-per-minute R  generated inputs per virtual minute (default 20)\n"
+              << "  --ticks-per-step N     simulation ticks per step (default 60)\n"
+              << "  --script FILE          replay input from FILE (see --write-script for the format)\n"
+              << "  --write-script FILE    save the input used to FILE\n"
+              << "  --out FILE             write JSON results to FILE instead of stdout\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    SoakOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--hours" && has_value) options.hours = std::atof(argv[++i]);
+        else if (arg == "--seed" && has_value) options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--size" && has_value && std::sscanf(argv[i + 1], "%dx%d", &options.width, &options.height) == 2 &&
+                 options.width > 0 && options.height > 0 && std::max(options.width, options.height) <= Constants::MAX_FARM_SIDE) ++i;
+        else if (arg == "--inputs-per-minute" && has_value) options.inputs_per_minute = std::atof(argv[++i]);
+        else if (arg == "--ticks-per-step" && has_value) options.ticks_per_step = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--script" && has_value) options.script_path = argv[++i];
+        else if (arg == "--write-script" && has_value) options.write_script_path = argv[++i];
+        else if (arg == "--out" && has_value) options.out_path = argv[++i];
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    const int64_t end_tick = static_cast<int64_t>(options.hours * 3600.0 * Constants::TICK_RATE);
+    std::vector<Input> script;
+    if (options.script_path.empty()) {
+        script = generate_script(options, end_tick);
+    } else if (!load_script(options.script_path, script)) {
+        std::cerr << "Cannot read input script " << options.script_path << std::endl;
+        return 1;
+    }
+    if (!options.write_script_path.empty() && !save_script(options.write_script_path, script)) {
+        std::cerr << "Cannot write " << options.write_script_path << std::endl;
+        return 1;
+    }
+
+    // A fresh save directory, so nothing from an earlier run is loaded or recovered.
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / ("alchemist_soak_" + std::to_string(Timing::now_ns()));
+    std::filesystem::create_directories(dir);
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    ClientOptions client;
+    client.adaptive = false;
+    client.software = true;
+    client.target_fps = 0.0;
+    client.uncapped_ticks = options.ticks_per_step;
+    client.seeded = true;
+    client.seed = options.seed;
+    client.save_path = (dir / "save.json").string();
+    // The client starts from a save holding a farm of the requested size.
+    if (!SaveManager::save(Game(options.width, options.height, options.seed), client.save_path)) {
+        std::cerr << "Cannot write the starting save in " << dir.string() << std::endl;
+        return 1;
+    }
+    const Camera::Rect view = Camera().get_viewport();
+
+    FrameHistogram frames;
+    int64_t last_frame = 0;
+    size_t next_input = 0;
+    bool quit_sent = false;
+    auto before_frame = [&](const RenderSnapshot& state) {
+        int64_t now = Timing::now_ns();
+        if (last_frame != 0) frames.add(now - last_frame);
+        last_frame = now;
+        for (; next_input < script.size() && script[next_input].tick <= state.tick; ++next_input) push_input(script[next_input], view);
+        if (state.tick >= end_tick && !quit_sent) {
+            SDL_Event event{};
+            event.type = SDL_QUIT;
+            SDL_PushEvent(&event);
+            quit_sent = true;
+        }
+    };
+
+    Log::Logger::instance().start();
+    uint64_t allocations = AllocCount::allocations(), allocated_bytes = AllocCount::bytes();
+    int64_t start = Timing::now_ns();
+    ClientSummary summary;
+    int status = run_client(client, before_frame, &summary);
+    double wall_seconds = static_cast<double>(Timing::now_ns() - start) / Constants::NANOSECONDS_PER_SECOND;
+    allocations = AllocCount::allocations() - allocations;
+    allocated_bytes = AllocCount::bytes() - allocated_bytes;
+    Log::Logger::instance().stop();
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    if (status != 0) return status;
+
+    double virtual_hours = static_cast<double>(summary.ticks) / Constants::TICK_RATE / 3600.0;
+    json report = {
+        {"context", {{"hours", options.hours}, {"seed", options.seed}, {"width", options.width}, {"height", options.height},
+                     {"ticks_per_step", options.ticks_per_step},
+                     {"script", options.script_path.empty() ? "generated" : options.script_path}}},
+        {"run", {{"ticks", summary.ticks}, {"virtual_hours", virtual_hours}, {"wall_seconds", wall_seconds},
+                 {"first_frame_ms", summary.first_frame_ms}, {"frames", frames.count()}, {"inputs", next_input}}},
+        {"frame_ms", {{"p50", frames.percentile_ms(0.50)}, {"p99", frames.percentile_ms(0.99)},
+                      {"p99_9", frames.percentile_ms(0.999)}, {"max", frames.max_ms()}}},
+        {"memory", {{"peak_rss_bytes", peak_rss_bytes()}, {"allocations", allocations}, {"allocated_bytes", allocated_bytes},
+                    {"allocations_per_frame", frames.count() ? static_cast<double>(allocations) / frames.count() : 0.0}}},
+        {"saves", {{"written", summary.saves.saves_written}, {"failed", summary.saves.saves_failed},
+                   {"coalesced", summary.saves.snapshots_coalesced}, {"bytes_written", summary.saves.bytes_written},
+                   {"journal_bytes", summary.journal_bytes}, {"max_latency_ms", summary.saves.max_latency_ms},
+                   {"bytes_per_virtual_hour", virtual_hours > 0 ? (summary.saves.bytes_written + summary.journal_bytes) / virtual_hours : 0.0}}},
+        {"game", {{"plants", summary.game.plants}, {"harvests", summary.game.harvests}, {"refines_started", summary.game.refines_started},
+                  {"refines_succeeded", summary.game.refines_succeeded}, {"pest_attacks", summary.game.pest_attacks},
+                  {"fields_lost", summary.game.fields_lost}}}};
+    if (options.out_path.empty()) {
+        std::cout << report.dump(Constants::JSON_INDENT) << std::endl;
+    } else {
+        std::ofstream file(options.out_path);
+        file << report.dump(Constants::JSON_INDENT) << std::endl;
+        if (!file) {
+            std::cerr << "Cannot write " << options.out_path << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
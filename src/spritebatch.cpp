@@ -0,0 +1,199 @@
+#include "spritebatch.h"
+#include "constants.h"
+#include "log.h"
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+
+namespace {
+    // Colours of the generated atlas, matching the flat fills the renderer used before sprites.
+    Constants::Color flat_color(size_t sprite) {
+        switch (static_cast<Sprite>(sprite)) {
+            case Sprite::PLOT_EMPTY: return Constants::GRAY;
+            case Sprite::BUTTON: return Constants::BLUE;
+            case Sprite::BUTTON_ACTIVE: return Constants::CYAN;
+            case Sprite::PANEL: return Constants::WHITE;
+            case Sprite::TILE_EMPTY: return Constants::GRAY;
+            case Sprite::TILE_GROWING: return Constants::GREEN;
+            case Sprite::TILE_READY: return Constants::RED;
+            default: break;
+        }
+        bool ready = (sprite - static_cast<size_t>(Sprite::FIRST_CROP)) % 2 == 1;
+        return ready ? Constants::RED : Constants::GREEN;
+    }
+}
+
+SpriteBatch::SpriteBatch()
+    : renderer_(nullptr), sheet_(nullptr), atlas_(nullptr), geometry_(false),
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+      atlas_width_(1), atlas_height_(1),
+#endif
+      last_sprites_(0), last_draw_calls_(0) {}
+
+SpriteBatch::~SpriteBatch() {
+    clear();
+}
+
+void SpriteBatch::clear() {
+    if (atlas_) SDL_DestroyTexture(atlas_);
+    atlas_ = nullptr;
+    if (sheet_) SDL_FreeSurface(sheet_);
+    sheet_ = nullptr;
+    quads_.clear();
+}
+
+bool SpriteBatch::load(const std::string& atlas_path) {
+    clear();
+    const size_t count = sprite_count();
+    const int rows = static_cast<int>((count + Constants::SPRITE_ATLAS_COLUMNS - 1) / Constants::SPRITE_ATLAS_COLUMNS);
+    cells_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        cells_[i] = SDL_Rect{static_cast<int>(i % Constants::SPRITE_ATLAS_COLUMNS) * Constants::SPRITE_CELL,
+                             static_cast<int>(i / Constants::SPRITE_ATLAS_COLUMNS) * Constants::SPRITE_CELL, Constants::SPRITE_CELL,
+                             Constants::SPRITE_CELL};
+    }
+    fallback_rects_.assign(count, {});
+
+    SDL_Surface* loaded = IMG_Load(atlas_path.c_str());
+    SDL_Surface* sheet = nullptr;
+    if (!loaded) {
+        LOG_INFO("Sprite atlas not found, using flat colours", {"path", atlas_path});
+    } else if (loaded->w < Constants::SPRITE_ATLAS_COLUMNS * Constants::SPRITE_CELL || loaded->h < rows * Constants::SPRITE_CELL) {
+        LOG_WARN("Sprite atlas is smaller than its layout, using flat colours", {"path", atlas_path}, {"sprites", count});
+    } else {
+        sheet = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    }
+    if (loaded) SDL_FreeSurface(loaded);
+    if (!sheet) sheet = generate_atlas();
+    if (!sheet) {
+        LOG_ERROR("Cannot build sprite atlas", {"error", SDL_GetError()});
+        return false;
+    }
+    // Average colour per cell, for the fill fallback.
+    average_.resize(cells_.size());
+    SDL_LockSurface(sheet);
+    for (size_t i = 0; i < cells_.size(); ++i) {
+        uint64_t sum[4] = {};
+        const SDL_Rect& cell = cells_[i];
+        for (int y = cell.y; y < cell.y + cell.h; ++y) {
+            const Uint8* row = static_cast<const Uint8*>(sheet->pixels) + y * sheet->pitch + cell.x * 4;
+            for (int x = 0; x < cell.w * 4; ++x) sum[x % 4] += row[x];
+        }
+        uint64_t pixels = static_cast<uint64_t>(cell.w) * cell.h;
+        average_[i] = SDL_Color{static_cast<Uint8>(sum[0] / pixels), static_cast<Uint8>(sum[1] / pixels), static_cast<Uint8>(sum[2] / pixels),
+                                static_cast<Uint8>(sum[3] / pixels)};
+    }
+    SDL_UnlockSurface(sheet);
+    sheet_ = sheet;
+    return true;
+}
+
+SDL_Surface* SpriteBatch::generate_atlas() const {
+    const int rows = static_cast<int>((cells_.size() + Constants::SPRITE_ATLAS_COLUMNS - 1) / Constants::SPRITE_ATLAS_COLUMNS);
+    SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, Constants::SPRITE_ATLAS_COLUMNS * Constants::SPRITE_CELL, rows * Constants::SPRITE_CELL, 32,
+                                                        SDL_PIXELFORMAT_RGBA32);
+    if (!sheet) return nullptr;
+    SDL_FillRect(sheet, nullptr, SDL_MapRGBA(sheet->format, 0, 0, 0, 0));
+    for (size_t i = 0; i < cells_.size(); ++i) {
+        Constants::Color color = flat_color(i);
+        SDL_FillRect(sheet, &cells_[i], SDL_MapRGBA(sheet->format, color.r, color.g, color.b, color.a));
+    }
+    return sheet;
+}
+
+bool SpriteBatch::upload(SDL_Renderer* renderer) {
+    renderer_ = renderer;
+    if (!sheet_) return false;
+    atlas_ = SDL_CreateTextureFromSurface(renderer_, sheet_);
+    int width = sheet_->w, height = sheet_->h;
+    SDL_FreeSurface(sheet_);
+    sheet_ = nullptr;
+    if (!atlas_) {
+        LOG_ERROR("Cannot upload sprite atlas", {"error", SDL_GetError()});
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas_, SDL_BLENDMODE_BLEND);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    geometry_ = true;
+    atlas_width_ = width;
+    atlas_height_ = height;
+#else
+    (void)width;
+    (void)height;
+#endif
+    return true;
+}
+
+void SpriteBatch::add(Sprite sprite, const SDL_Rect& dst) {
+    if (static_cast<size_t>(sprite) >= cells_.size()) return;
+    quads_.push_back(Quad{sprite, dst, 0.0f, 0.0f, 1.0f, 1.0f});
+}
+
+void SpriteBatch::add(Sprite sprite, const SDL_Rect& dst, const SDL_Rect& clip) {
+    SDL_Rect visible;
+    if (static_cast<size_t>(sprite) >= cells_.size() || !SDL_IntersectRect(&dst, &clip, &visible)) return;
+    float w = static_cast<float>(dst.w), h = static_cast<float>(dst.h);
+    quads_.push_back(Quad{sprite, visible, (visible.x - dst.x) / w, (visible.y - dst.y) / h, (visible.x + visible.w - dst.x) / w,
+                          (visible.y + visible.h - dst.y) / h});
+}
+
+void SpriteBatch::flush() {
+    last_sprites_ = quads_.size();
+    last_draw_calls_ = 0;
+    if (quads_.empty() || !atlas_) {
+        quads_.clear();
+        return;
+    }
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (geometry_) {
+        vertices_.clear();
+        // Texture coordinates are inset half a texel so filtering never samples a neighbouring cell.
+        const float inset_u = 0.5f / atlas_width_, inset_v = 0.5f / atlas_height_;
+        const SDL_Color white = Constants::toSDLColor(Constants::WHITE);
+        for (const Quad& quad : quads_) {
+            const SDL_Rect& src = cells_[static_cast<size_t>(quad.sprite)];
+            const SDL_Rect& dst = quad.dst;
+            float u0 = (src.x + quad.u0 * src.w) / atlas_width_ + inset_u, u1 = (src.x + quad.u1 * src.w) / atlas_width_ - inset_u;
+            float v0 = (src.y + quad.v0 * src.h) / atlas_height_ + inset_v, v1 = (src.y + quad.v1 * src.h) / atlas_height_ - inset_v;
+            float x0 = static_cast<float>(dst.x), x1 = static_cast<float>(dst.x + dst.w);
+            float y0 = static_cast<float>(dst.y), y1 = static_cast<float>(dst.y + dst.h);
+            vertices_.push_back(SDL_Vertex{{x0, y0}, white, {u0, v0}});
+            vertices_.push_back(SDL_Vertex{{x1, y0}, white, {u1, v0}});
+            vertices_.push_back(SDL_Vertex{{x1, y1}, white, {u1, v1}});
+            vertices_.push_back(SDL_Vertex{{x0, y1}, white, {u0, v1}});
+        }
+        for (int quad = static_cast<int>(indices_.size() / 6); quad < static_cast<int>(quads_.size()); ++quad) {
+            int base = quad * 4;
+            indices_.insert(indices_.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+        }
+        if (SDL_RenderGeometry(renderer_, atlas_, vertices_.data(), static_cast<int>(vertices_.size()), indices_.data(),
+                               static_cast<int>(quads_.size() * 6)) == 0) {
+            last_draw_calls_ = 1;
+            quads_.clear();
+            return;
+        }
+        LOG_WARN("SDL_RenderGeometry failed, drawing sprites as filled rects", {"error", SDL_GetError()});
+        geometry_ = false;
+    }
+#endif
+    flush_rects();
+}
+
+// One fill call per sprite kind, in order of first use, so later kinds (the
+// overlay panel) still cover earlier ones (plots).
+void SpriteBatch::flush_rects() {
+    for (auto& rects : fallback_rects_) rects.clear();
+    order_.clear();
+    for (const Quad& quad : quads_) {
+        std::vector<SDL_Rect>& rects = fallback_rects_[static_cast<size_t>(quad.sprite)];
+        if (rects.empty()) order_.push_back(quad.sprite);
+        rects.push_back(quad.dst);
+    }
+    for (Sprite sprite : order_) {
+        const SDL_Color& color = average_[static_cast<size_t>(sprite)];
+        const std::vector<SDL_Rect>& rects = fallback_rects_[static_cast<size_t>(sprite)];
+        SDL_SetRenderDrawColor(renderer_, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRects(renderer_, rects.data(), static_cast<int>(rects.size()));
+        ++last_draw_calls_;
+    }
+    quads_.clear();
+}
@@ -0,0 +1,567 @@
+// Behaviour tests for the core library. Run by ctest; pass test names to run
+// only those.
+#include "binarysave.h"
+#include "game.h"
+#include "journal.h"
+#include "jsonwriter.h"
+#include "log.h"
+#include "replay.h"
+#include "rng.h"
+#include "savemanager.h"
+#include "saveservice.h"
+#include "snapshot.h"
+#include "timing.h"
+#include "triplebuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                                      \
+    do {                                                                                 \
+        if (!(cond)) {                                                                   \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++failures;                                                                  \
+        }                                                                                \
+    } while (0)
+
+// A fresh directory under the system temp dir, removed with everything in it.
+struct TempDir {
+    std::filesystem::path path;
+    explicit TempDir(const std::string& name)
+        : path(std::filesystem::temp_directory_path() / ("alchemist_test_" + name + "_" + std::to_string(Timing::now_ns()))) {
+        std::filesystem::create_directories(path);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+    std::string file(const std::string& name) const { return (path / name).string(); }
+};
+
+void test_save_service_retry() {
+    TempDir dir("save_service");
+    const std::string path = dir.file("save.json");
+    const std::string temp_path = path + Constants::SAVE_TEMP_SUFFIX;
+    std::filesystem::create_directories(temp_path); // The writer cannot create its temp file
+    Game game(4, 4, 16);
+    SaveService service(path, 0.0);
+    service.start(game);
+    game.plant(0, Registry::get().fire_grass);
+    service.flush(game);
+    CHECK(service.get_stats().saves_failed == 1);
+    CHECK(service.get_stats().saves_written == 0);
+    CHECK(!std::filesystem::exists(path));
+
+    // Nothing changed since, but the failed write left the game dirty.
+    std::filesystem::remove(temp_path);
+    CHECK(service.poll(game));
+    service.flush(game);
+    service.stop();
+    CHECK(service.get_stats().saves_written == 1);
+    CHECK(service.get_stats().last_revision == game.get_revision());
+    Game loaded;
+    int64_t saved_at_ms;
+    CHECK(SaveManager::read(path, loaded, saved_at_ms));
+    CHECK(loaded.get_state_hash() == game.get_state_hash());
+}
+
+// Seed and command log reproduce a session: the replayed game serializes to
+// the same bytes as the live one.
+void test_replay_reproduces_session() {
+    TempDir dir("replay");
+    const Registry& registry = Registry::get();
+    const double dt = 1.0 / Constants::TICK_RATE;
+    Game live(5, 4, 21);
+    CommandLog log;
+    log.begin(live, dt);
+    Rng input(22);
+    const int64_t end_tick = static_cast<int64_t>(120.0 / dt);
+    for (int64_t tick = 0; tick <= end_tick; ++tick) {
+        if (input.next_double() < 0.05) {
+            Command command{tick, CommandType::PLANT, static_cast<int32_t>(input.next_u64() % 20), registry.fire_grass};
+            double roll = input.next_double();
+            if (roll < 0.4) command.type = CommandType::HARVEST;
+            else if (roll < 0.5) command.type = CommandType::START_REFINING;
+            else if (roll < 0.55) command = Command{tick, CommandType::SET_FLAME, 0, registry.next_flame(live.get_flame_type())};
+            log.execute(live, command);
+        }
+        if (tick < end_tick) live.update(dt);
+    }
+    log.finish(end_tick);
+    CHECK(log.size() > 10);
+    CHECK(live.get_stats().harvests > 0);
+
+    const std::string path = dir.file("session.replay");
+    CHECK(log.save(path));
+    CommandLog loaded;
+    CHECK(loaded.load(path));
+    CHECK(loaded.size() == log.size());
+    Game replayed;
+    CHECK(loaded.replay(replayed));
+    CHECK(replayed.get_state_hash() == live.get_state_hash());
+    CHECK(SaveManager::serialize(replayed) == SaveManager::serialize(live));
+}
+
+// Sizes in a damaged log are refused before anything is allocated for them.
+void test_replay_rejects_corrupt_sizes() {
+    TempDir dir("replay_corrupt");
+    Game game(4, 4, 23);
+    CommandLog log;
+    log.begin(game, 0.1);
+    log.execute(game, Command{0, CommandType::PLANT, 3, Registry::get().fire_grass});
+    const std::string path = dir.file("session.replay");
+    CHECK(log.save(path));
+    std::string text;
+    {
+        std::ifstream file(path, std::ios::binary);
+        text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    auto load_edited = [&](const std::string& from, const std::string& to) {
+        std::string edited = text;
+        size_t at = edited.find(from);
+        if (at == std::string::npos) return true;
+        edited.replace(at, from.size(), to);
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << edited;
+        CommandLog damaged;
+        return damaged.load(path);
+    };
+    CHECK(load_edited("\ncommands 1\n", "\ncommands 1\n"));
+    CHECK(!load_edited("\nsnapshot ", "\nsnapshot 9999999999999"));
+    CHECK(!load_edited("\ncommands 1\n", "\ncommands 4000000000000\n"));
+    CHECK(!load_edited("\ncommands 1\n", "\ncommands 2\n"));
+}
+
+std::vector<uint8_t> read_bytes(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Plays a short session through the journal the way the client does and
+// returns the live game at the end.
+Game journaled_session(const std::string& save_path) {
+    const Registry& registry = Registry::get();
+    Game game(4, 4, 14);
+    SaveManager::save(game, save_path);
+    Journal journal(save_path);
+    CHECK(journal.open(game));
+    int64_t tick = 0;
+    auto run = [&](const Command& command) {
+        if (execute_command(game, command)) journal.record(game, command);
+    };
+    for (int i = 0; i < 16; ++i) {
+        run(Command{tick++, CommandType::PLANT, i, registry.fire_grass});
+        game.update(0.7);
+        journal.observe(game);
+    }
+    for (int step = 0; step < 40; ++step) {
+        game.update(0.5);
+        journal.observe(game);
+    }
+    for (int i = 0; i < 16; ++i) run(Command{tick++, CommandType::HARVEST, i, 0});
+    run(Command{tick++, CommandType::SET_FLAME, 0, registry.next_flame(game.get_flame_type())});
+    run(Command{tick++, CommandType::START_REFINING, 0, 0});
+    game.update(Constants::REFINE_TIME + 1.0);
+    journal.observe(game);
+    run(Command{tick++, CommandType::PLANT, 5, registry.wood_grass});
+    journal.close();
+    return game;
+}
+
+void test_journal_recovery() {
+    TempDir dir("journal");
+    const std::string save_path = dir.file("save.json");
+    Game live = journaled_session(save_path);
+
+    Game recovered;
+    int64_t saved_at_ms;
+    CHECK(SaveManager::read(save_path, recovered, saved_at_ms));
+    size_t applied = Journal::recover(save_path, recovered);
+    CHECK(applied > 16);
+    CHECK(recovered.get_state_hash() == live.get_state_hash());
+    CHECK(recovered.get_stats().plants == live.get_stats().plants);
+    CHECK(recovered.get_stats().pest_attacks == live.get_stats().pest_attacks);
+    CHECK(recovered.get_stats().refines_succeeded + recovered.get_stats().refines_failed == 1);
+
+    // A segment that does not continue the snapshot (here: a later snapshot
+    // reached disk) is skipped rather than replayed twice.
+    CHECK(SaveManager::save(live, save_path));
+    Game resaved;
+    CHECK(SaveManager::read(save_path, resaved, saved_at_ms));
+    CHECK(Journal::recover(save_path, resaved) == 0);
+    CHECK(resaved.get_state_hash() == live.get_state_hash());
+}
+
+void test_journal_torn_record() {
+    TempDir dir("journal_torn");
+    const std::string save_path = dir.file("save.json");
+    journaled_session(save_path);
+    const std::string segment = save_path + Constants::JOURNAL_SUFFIX + ".0";
+    CHECK(std::filesystem::exists(segment));
+
+    Game whole;
+    int64_t saved_at_ms;
+    CHECK(SaveManager::read(save_path, whole, saved_at_ms));
+    size_t applied = Journal::recover(save_path, whole);
+
+    // A crash mid-write leaves the last record short: everything before it replays.
+    std::filesystem::resize_file(segment, std::filesystem::file_size(segment) - 1);
+    Game torn;
+    CHECK(SaveManager::read(save_path, torn, saved_at_ms));
+    CHECK(Journal::recover(save_path, torn) == applied - 1);
+    CHECK(torn.get_fields().is_empty(5)); // The last command was the wood_grass planting
+    CHECK(!whole.get_fields().is_empty(5));
+
+    // Garbage after the last whole record stops recovery at that record.
+    std::vector<uint8_t> bytes = read_bytes(segment);
+    bytes.insert(bytes.end(), {0xff, 0x13, 0x37});
+    std::ofstream(segment, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    Game corrupt;
+    CHECK(SaveManager::read(save_path, corrupt, saved_at_ms));
+    CHECK(Journal::recover(save_path, corrupt) <= applied - 1);
+    CHECK(corrupt.get_state_hash() == corrupt.compute_state_hash());
+}
+
+// advance() settles every pest check of an absence with geometric draws;
+// the attack count must follow the same binomial as checking one by one.
+void test_fast_forward_pests() {
+    constexpr int GAMES = 200;
+    constexpr double SECONDS = 20000.0;
+    const double checks = SECONDS / Constants::PEST_CHECK_INTERVAL;
+    const double p = Constants::PEST_ATTACK_PROBABILITY;
+    const double expected = GAMES * checks * p;
+    const double tolerance = 5.0 * std::sqrt(GAMES * checks * p * (1.0 - p)) + GAMES;
+
+    uint64_t bulk = 0, stepped = 0;
+    for (int i = 0; i < GAMES; ++i) {
+        Game fast(4, 4, 1000 + i);
+        fast.advance(SECONDS);
+        bulk += fast.get_stats().pest_attacks;
+        CHECK(std::llabs(fast.get_time() - to_game_time(SECONDS)) <= 1);
+
+        Game slow(4, 4, 5000 + i);
+        for (double t = 0; t < SECONDS; t += Constants::PEST_CHECK_INTERVAL) slow.update(Constants::PEST_CHECK_INTERVAL);
+        stepped += slow.get_stats().pest_attacks;
+    }
+    CHECK(std::fabs(bulk - expected) < tolerance);
+    CHECK(std::fabs(stepped - expected) < tolerance);
+
+    // Plots growing when the absence starts are lost to the first attack.
+    Game planted(4, 4, 77);
+    for (int i = 0; i < 16; ++i) planted.plant(i, Registry::get().fire_grass);
+    uint64_t revision = planted.get_revision();
+    planted.advance(SECONDS);
+    CHECK(planted.get_stats().pest_attacks > 0);
+    CHECK(planted.get_revision() > revision);
+    CHECK(planted.get_state_hash() == planted.compute_state_hash());
+
+    // An absence in which nothing changes leaves the game clean for the save service.
+    Game bare(4, 4, 78);
+    revision = bare.get_revision();
+    bare.advance(SECONDS);
+    CHECK(bare.get_stats().pest_attacks > 0);
+    CHECK(bare.get_revision() == revision);
+}
+
+// A game with something in every part of the state: growing, ready and empty
+// plots, inventory, a non-default flame, proficiency and a refine under way.
+Game played_game(uint64_t seed) {
+    const Registry& registry = Registry::get();
+    Game game(6, 5, seed);
+    for (int i = 0; i < 30; i += 3) game.plant(i, registry.fire_grass);
+    game.update(Constants::DEFAULT_GROWTH_TIME + 1.0);
+    ItemId harvested;
+    for (int i = 0; i < 30; i += 6) game.harvest(i, harvested);
+    for (int i = 1; i < 30; i += 4) game.plant(i, registry.wood_grass);
+    game.restore_item_count(registry.fire_grass, 5);
+    game.set_flame_type(registry.next_flame(game.get_flame_type()));
+    game.set_proficiency(7);
+    game.start_refining();
+    return game;
+}
+
+bool same_game(const Game& a, const Game& b) {
+    const FieldStore& fa = a.get_fields();
+    const FieldStore& fb = b.get_fields();
+    if (fa.get_width() != fb.get_width() || fa.get_height() != fb.get_height()) return false;
+    for (size_t i = 0; i < fa.size(); ++i) {
+        if (fa.get_crop(i) != fb.get_crop(i) || fa.is_ready(i) != fb.is_ready(i)) return false;
+        if (!fa.is_empty(i) && fa.get_ready_at(i) != fb.get_ready_at(i)) return false;
+    }
+    for (ItemId item = 0; item < a.get_inventory().size(); ++item) {
+        if (a.get_inventory().get(item) != b.get_inventory().get(item)) return false;
+    }
+    return a.get_time() == b.get_time() && a.get_rng().get_state() == b.get_rng().get_state() &&
+           a.get_rng().get_seed() == b.get_rng().get_seed() && a.get_flame_type() == b.get_flame_type() &&
+           a.get_proficiency() == b.get_proficiency() && a.is_refining() == b.is_refining() &&
+           (!a.is_refining() || a.get_refine_done_at() == b.get_refine_done_at()) && a.get_state_hash() == b.get_state_hash();
+}
+
+// Rewrites a file's checksum after a test edits its records.
+void reseal(std::vector<uint8_t>& buffer) {
+    BinarySave::Header header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    header.checksum = BinarySave::checksum(buffer.data() + sizeof(header), buffer.size() - sizeof(header));
+    std::memcpy(buffer.data(), &header, sizeof(header));
+}
+
+void test_save_round_trip() {
+    TempDir dir("round_trip");
+    Game game = played_game(11);
+    const std::string json_path = dir.file("save.json");
+    const std::string binary_path = dir.file("save" + Constants::BINARY_SAVE_SUFFIX);
+    const std::string back_path = dir.file("back.json");
+    CHECK(SaveManager::save(game, json_path));
+    CHECK(SaveManager::convert(json_path, binary_path));
+    CHECK(SaveManager::convert(binary_path, back_path));
+    CHECK(SaveManager::format_for(binary_path) == SaveFormat::BINARY);
+
+    for (const std::string& path : {json_path, binary_path, back_path}) {
+        Game loaded;
+        int64_t saved_at_ms = 0;
+        CHECK(SaveManager::read(path, loaded, saved_at_ms));
+        CHECK(saved_at_ms > 0);
+        CHECK(same_game(game, loaded));
+    }
+}
+
+void test_binary_migrate() {
+    // A file from before StateRecord gained state_hash: the same sections
+    // with a 88-byte state stride.
+    Game game = played_game(12);
+    std::string current = BinarySave::encode(game, 1234);
+    BinarySave::Header header;
+    std::memcpy(&header, current.data(), sizeof(header));
+    constexpr uint32_t OLD_STATE_BYTES = offsetof(BinarySave::StateRecord, state_hash);
+    const size_t shift = sizeof(BinarySave::StateRecord) - OLD_STATE_BYTES;
+    std::vector<uint8_t> old(current.size() - shift);
+    std::memcpy(old.data() + sizeof(header), current.data() + header.state.offset, OLD_STATE_BYTES);
+    std::memcpy(old.data() + sizeof(header) + OLD_STATE_BYTES, current.data() + header.fields.offset, current.size() - header.fields.offset);
+    header.state.stride = OLD_STATE_BYTES;
+    for (BinarySave::Section* section : {&header.fields, &header.inventory, &header.names}) section->offset -= shift;
+    header.file_bytes = old.size();
+    std::memcpy(old.data(), &header, sizeof(header));
+    reseal(old);
+
+    CHECK(BinarySave::needs_migration(old.data(), old.size()));
+    BinarySave::View view;
+    std::string error;
+    CHECK(!view.open(old.data(), old.size(), error));
+    CHECK(BinarySave::migrate(old, error));
+    CHECK(!BinarySave::needs_migration(old.data(), old.size()));
+    CHECK(view.open(old.data(), old.size(), error));
+    CHECK(view.state().state_hash == 0); // Zero-filled: not in the old layout
+    CHECK(view.state().saved_at == 1234);
+    Game loaded;
+    view.apply(loaded);
+    CHECK(same_game(game, loaded));
+
+    std::vector<uint8_t> newer(current.begin(), current.end());
+    std::memcpy(&header, newer.data(), sizeof(header));
+    header.version = BinarySave::VERSION + 1;
+    std::memcpy(newer.data(), &header, sizeof(header));
+    CHECK(!BinarySave::migrate(newer, error));
+}
+
+void test_binary_rejects_bad_dimensions() {
+    Game game(4, 3, 13);
+    std::string binary = BinarySave::encode(game);
+    BinarySave::Header header;
+    std::memcpy(&header, binary.data(), sizeof(header));
+    auto open_with = [&](int32_t width, int32_t height) {
+        std::vector<uint8_t> edited(binary.begin(), binary.end());
+        BinarySave::StateRecord state;
+        std::memcpy(&state, edited.data() + header.state.offset, sizeof(state));
+        state.width = width;
+        state.height = height;
+        std::memcpy(edited.data() + header.state.offset, &state, sizeof(state));
+        reseal(edited);
+        BinarySave::View view;
+        std::string error;
+        return view.open(edited.data(), edited.size(), error);
+    };
+    CHECK(open_with(4, 3));
+    CHECK(!open_with(3, 3)); // 12 plots saved for a 3x3 farm
+    CHECK(!open_with(Constants::MAX_FARM_SIDE + 1, 1));
+    CHECK(!open_with(-4, -3));
+}
+
+// serialize() streams the save through JsonWriter; the file must stay byte
+// for byte what nlohmann's dump() wrote for the same state.
+void test_json_matches_dump() {
+    Game game = played_game(17);
+    const std::string text = SaveManager::serialize(game, 1700000000000);
+    CHECK(nlohmann::json::parse(text).dump(Constants::JSON_INDENT) == text);
+    CHECK(text.find("planted_at") == std::string::npos);
+
+    const double values[] = {0.0, -0.0, 1.0, 10.0, 100000.0, 1e15, 1e16, 1e20, -2.5e-7, 0.001, 0.0001, 1.0 / 3.0,
+                             3.6175918579101562, 2.172940778156851e16, 1e-300, std::numeric_limits<double>::max(),
+                             std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity()};
+    for (double value : values) {
+        std::string out;
+        JsonWriter writer(out);
+        writer.value(value);
+        CHECK(out == nlohmann::json(value).dump());
+    }
+}
+
+void test_json_rejects_bad_dimensions() {
+    Game game(4, 3, 13);
+    std::string json = SaveManager::serialize(game);
+    auto with_width = [&json](const std::string& width) {
+        std::string edited = json;
+        size_t at = edited.find("\"width\": 4");
+        edited.replace(at, std::strlen("\"width\": 4"), "\"width\": " + width);
+        return edited;
+    };
+    Game loaded;
+    CHECK(SaveManager::deserialize(json, loaded));
+    CHECK(!SaveManager::deserialize(with_width(std::to_string(Constants::MAX_FARM_SIDE + 1)), loaded));
+    CHECK(!SaveManager::deserialize(with_width("4294967300"), loaded)); // Would wrap to 4 as an int
+    CHECK(!SaveManager::deserialize(with_width("0"), loaded));
+    CHECK(!SaveManager::deserialize(with_width("5"), loaded)); // 12 plots saved for a 5x3 farm
+}
+
+void test_state_hash_mismatch() {
+    Game game = played_game(15);
+    CHECK(game.get_state_hash() == game.compute_state_hash());
+    Game other = played_game(15);
+    CHECK(other.get_state_hash() == game.get_state_hash());
+    ItemId harvested;
+    other.plant(2, Registry::get().wood_grass);
+    other.harvest(3, harvested);
+    CHECK(other.get_state_hash() == other.compute_state_hash());
+    CHECK(other.get_state_hash() != game.get_state_hash());
+
+    // A save edited by hand keeps its stored hash, which no longer matches
+    // the state it loads.
+    std::string json = SaveManager::serialize(game);
+    CHECK(json.find("\"state_hash\"") != std::string::npos);
+    size_t crop = json.find("\"fire_grass\"");
+    CHECK(crop != std::string::npos);
+    json.replace(crop, std::strlen("\"fire_grass\""), "\"wood_grass\"");
+    Game tampered;
+    CHECK(SaveManager::deserialize(json, tampered));
+    CHECK(tampered.get_state_hash() == tampered.compute_state_hash());
+    CHECK(tampered.get_state_hash() != game.get_state_hash());
+}
+
+bool same_snapshot(const RenderSnapshot& a, const RenderSnapshot& b) {
+    return a.width == b.width && a.height == b.height && a.plots == b.plots && a.block_ready == b.block_ready &&
+           a.block_growing == b.block_growing && a.revision == b.revision && a.flame == b.flame &&
+           a.refining == b.refining && a.inventory.get(Registry::get().fire_grass) == b.inventory.get(Registry::get().fire_grass);
+}
+
+void test_snapshot_incremental() {
+    const Registry& registry = Registry::get();
+    Game game(40, 35, 21); // Several blocks, with partial ones on the right and bottom edges
+    TripleBuffer<RenderSnapshot> snapshots;
+    auto check_published = [&] {
+        snapshots.back().capture(game);
+        RenderSnapshot full;
+        full.capture(game);
+        CHECK(same_snapshot(snapshots.back(), full));
+        snapshots.publish();
+    };
+    check_published();
+    ItemId harvested;
+    for (int round = 0; round < 12; ++round) {
+        for (int i = round; i < 40 * 35; i += 37 + round) game.plant(i, round % 2 ? registry.wood_grass : registry.fire_grass);
+        check_published();
+        game.update(Constants::DEFAULT_GROWTH_TIME / 3);
+        check_published();
+        for (int i = round * 5; i < 40 * 35; i += 53) game.harvest(i, harvested);
+        check_published();
+    }
+    check_published(); // Nothing changed since the last capture
+
+    // A different store, even one of the same size, is copied over in full.
+    game = played_game(21);
+    check_published();
+    game = Game(40, 35, 22);
+    check_published();
+}
+
+// Stops the logger while producers are still pushing: every record must end
+// up either written or counted as dropped.
+void test_logger_stop_accounts_every_record() {
+    TempDir dir("logger_stop");
+    Log::Logger& logger = Log::Logger::instance();
+    for (int round = 0; round < 20; ++round) {
+        CHECK(logger.start(dir.file("log.txt")));
+        const uint64_t before = logger.get_written() + logger.get_dropped();
+        std::atomic<uint64_t> pushed{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 4; ++t) {
+            producers.emplace_back([&] {
+                while (!go.load()) std::this_thread::yield();
+                for (int i = 0; i < 2000; ++i) {
+                    Log::write(Log::Level::DEBUG, "Logger stop test", {"i", i});
+                    pushed.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        go.store(true);
+        std::this_thread::sleep_for(std::chrono::microseconds(100 * round));
+        logger.stop();
+        for (std::thread& producer : producers) producer.join();
+        CHECK(logger.get_written() + logger.get_dropped() - before == pushed.load());
+    }
+}
+
+struct Test {
+    const char* name;
+    std::function<void()> run;
+};
+
+const std::vector<Test> TESTS = {
+    {"save_service_retry", test_save_service_retry},
+    {"replay_reproduces_session", test_replay_reproduces_session},
+    {"replay_rejects_corrupt_sizes", test_replay_rejects_corrupt_sizes},
+    {"journal_recovery", test_journal_recovery},
+    {"journal_torn_record", test_journal_torn_record},
+    {"fast_forward_pests", test_fast_forward_pests},
+    {"save_round_trip", test_save_round_trip},
+    {"binary_migrate", test_binary_migrate},
+    {"binary_rejects_bad_dimensions", test_binary_rejects_bad_dimensions},
+    {"json_matches_dump", test_json_matches_dump},
+    {"json_rejects_bad_dimensions", test_json_rejects_bad_dimensions},
+    {"state_hash_mismatch", test_state_hash_mismatch},
+    {"snapshot_incremental", test_snapshot_incremental},
+    {"logger_stop_accounts_every_record", test_logger_stop_accounts_every_record},
+};
+
+}
+
+int main(int argc, char** argv) {
+    int ran = 0;
+    for (const Test& test : TESTS) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) selected = selected || std::string_view(argv[i]) == test.name;
+        if (!selected) continue;
+        int before = failures;
+        test.run();
+        ++ran;
+        std::printf("%-30s %s\n", test.name, failures == before ? "ok" : "FAILED");
+    }
+    if (argc > 1 && ran == 0) {
+        std::fprintf(stderr, "No test matches the given names\n");
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+#include "textcache.h"
+#include "constants.h"
+#include "log.h"
+#include <algorithm>
+
+TextCache::TextCache() : renderer_(nullptr), font_(nullptr), sheet_(nullptr), atlas_(nullptr), glyphs_{}, line_height_(0) {}
+
+TextCache::~TextCache() {
+    clear();
+}
+
+void TextCache::clear() {
+    for (auto& [key, entry] : entries_) {
+        if (entry.texture) SDL_DestroyTexture(entry.texture);
+    }
+    entries_.clear();
+    if (atlas_) SDL_DestroyTexture(atlas_);
+    atlas_ = nullptr;
+    if (sheet_) SDL_FreeSurface(sheet_);
+    sheet_ = nullptr;
+}
+
+void TextCache::draw(std::string_view key, std::string_view text, const SDL_Rect& dst) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        it = entries_.emplace(std::string(key), Entry{std::string(), nullptr}).first;
+    }
+    Entry& entry = it->second;
+    if (!entry.texture || entry.text != text) {
+        if (entry.texture) SDL_DestroyTexture(entry.texture);
+        entry.texture = nullptr;
+        entry.text = text;
+        SDL_Surface* surface = TTF_RenderUTF8_Solid(font_, entry.text.c_str(), Constants::toSDLColor(Constants::WHITE));
+        if (!surface) return;
+        entry.texture = SDL_CreateTextureFromSurface(renderer_, surface);
+        SDL_FreeSurface(surface);
+        if (!entry.texture) return;
+    }
+    SDL_RenderCopy(renderer_, entry.texture, nullptr, &dst);
+}
+
+void TextCache::draw_glyphs(std::string_view text, int x, int y, const Constants::Color& color) {
+    if (!atlas_) return;
+    SDL_SetTextureColorMod(atlas_, color.r, color.g, color.b);
+    for (char c : text) {
+        if (c < FIRST_GLYPH || c > LAST_GLYPH) c = '?';
+        const Glyph& glyph = glyphs_[c - FIRST_GLYPH];
+        SDL_Rect dst = {x, y, glyph.src.w, glyph.src.h};
+        SDL_RenderCopy(renderer_, atlas_, &glyph.src, &dst);
+        x += glyph.advance;
+    }
+}
+
+bool TextCache::rasterize(TTF_Font* font) {
+    clear();
+    font_ = font;
+    constexpr int glyph_count = LAST_GLYPH - FIRST_GLYPH + 1;
+    std::array<SDL_Surface*, glyph_count> surfaces{};
+    int cell_w = 1, cell_h = 1;
+    for (int i = 0; i < glyph_count; ++i) {
+        Uint16 ch = static_cast<Uint16>(FIRST_GLYPH + i);
+        surfaces[i] = TTF_RenderGlyph_Solid(font_, ch, Constants::toSDLColor(Constants::WHITE));
+        int advance = 0;
+        TTF_GlyphMetrics(font_, ch, nullptr, nullptr, nullptr, nullptr, &advance);
+        glyphs_[i].advance = advance;
+        if (surfaces[i]) {
+            cell_w = std::max(cell_w, surfaces[i]->w);
+            cell_h = std::max(cell_h, surfaces[i]->h);
+        }
+    }
+    line_height_ = cell_h;
+
+    int rows = (glyph_count + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+    SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, cell_w * ATLAS_COLUMNS, cell_h * rows, 32, SDL_PIXELFORMAT_RGBA32);
+    if (sheet) SDL_FillRect(sheet, nullptr, SDL_MapRGBA(sheet->format, 0, 0, 0, 0));
+    for (int i = 0; i < glyph_count; ++i) {
+        SDL_Rect cell = {(i % ATLAS_COLUMNS) * cell_w, (i / ATLAS_COLUMNS) * cell_h, 0, 0};
+        if (surfaces[i]) {
+            cell.w = surfaces[i]->w;
+            cell.h = surfaces[i]->h;
+            if (sheet) SDL_BlitSurface(surfaces[i], nullptr, sheet, &cell);
+            SDL_FreeSurface(surfaces[i]);
+        }
+        glyphs_[i].src = cell;
+    }
+    if (!sheet) {
+        LOG_ERROR("Cannot build glyph atlas", {"error", SDL_GetError()});
+        return false;
+    }
+    sheet_ = sheet;
+    return true;
+}
+
+bool TextCache::upload(SDL_Renderer* renderer) {
+    renderer_ = renderer;
+    if (!sheet_) return false;
+    atlas_ = SDL_CreateTextureFromSurface(renderer_, sheet_);
+    SDL_FreeSurface(sheet_);
+    sheet_ = nullptr;
+    if (!atlas_) {
+        LOG_ERROR("Cannot upload glyph atlas", {"error", SDL_GetError()});
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas_, SDL_BLENDMODE_BLEND);
+    return true;
+}
@@ -0,0 +1,92 @@
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) : generation_(0), stopping_(false), job_(nullptr), pending_(0), steals_(0) {
+    threads = std::max<size_t>(1, threads);
+    for (size_t i = 0; i < threads; ++i) queues_.push_back(std::make_unique<Queue>());
+    for (size_t i = 1; i < threads; ++i) threads_.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& thread : threads_) thread.join();
+}
+
+void ThreadPool::parallel_for(size_t count, size_t chunk, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) return;
+    chunk = std::max<size_t>(1, chunk);
+    size_t chunks = (count + chunk - 1) / chunk;
+    if (queues_.size() == 1 || chunks == 1) {
+        for (size_t begin = 0; begin < count; begin += chunk) fn(begin, std::min(count, begin + chunk));
+        return;
+    }
+
+    // Publish the job before any chunk becomes visible to a worker.
+    job_ = &fn;
+    pending_.store(chunks, std::memory_order_relaxed);
+    for (size_t c = 0; c < chunks; ++c) {
+        Queue& queue = *queues_[c * queues_.size() / chunks];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.ranges.push_back(Range{c * chunk, std::min(count, (c + 1) * chunk)});
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+    }
+    wake_cv_.notify_all();
+
+    while (run_one(0)) {}
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_cv_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+        }
+        while (run_one(index)) {}
+    }
+}
+
+// Runs one chunk from the worker's own queue (front, in address order) or, failing
+// that, steals from the back of the others. Returns false when every queue is empty.
+bool ThreadPool::run_one(size_t index) {
+    Range range{};
+    bool found = false;
+    {
+        Queue& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.ranges.empty()) {
+            range = own.ranges.front();
+            own.ranges.pop_front();
+            found = true;
+        }
+    }
+    for (size_t i = 1; !found && i < queues_.size(); ++i) {
+        Queue& victim = *queues_[(index + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.back();
+            victim.ranges.pop_back();
+            found = true;
+            steals_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (!found) return false;
+
+    (*job_)(range.begin, range.end);
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_cv_.notify_all();
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#include "timing.h"
+#include <chrono>
+#include <thread>
+
+namespace Timing {
+    int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t unix_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+FixedTimestep::FixedTimestep(double tick_rate, int max_ticks)
+    : step_ns_(static_cast<int64_t>(Constants::NANOSECONDS_PER_SECOND / tick_rate)),
+      max_ticks_(max_ticks > 0 ? max_ticks : 1), accumulator_ns_(0), dropped_ns_(0) {
+    if (step_ns_ <= 0) step_ns_ = 1;
+}
+
+int FixedTimestep::advance(int64_t elapsed_ns) {
+    if (elapsed_ns > 0) accumulator_ns_ += elapsed_ns;
+    int64_t ticks = accumulator_ns_ / step_ns_;
+    if (ticks > max_ticks_) {
+        int64_t dropped = (ticks - max_ticks_) * step_ns_;
+        dropped_ns_ += dropped;
+        accumulator_ns_ -= dropped;
+        ticks = max_ticks_;
+    }
+    accumulator_ns_ -= ticks * step_ns_;
+    return static_cast<int>(ticks);
+}
+
+int64_t FixedTimestep::advance_all(int64_t elapsed_ns) {
+    if (elapsed_ns > 0) accumulator_ns_ += elapsed_ns;
+    int64_t ticks = accumulator_ns_ / step_ns_;
+    accumulator_ns_ -= ticks * step_ns_;
+    return ticks;
+}
+
+FrameLimiter::FrameLimiter(double target_fps)
+    : frame_ns_(target_fps > 0 ? static_cast<int64_t>(Constants::NANOSECONDS_PER_SECOND / target_fps) : 0),
+      next_deadline_ns_(0), sleep_error_ns_(0.0), overshoot_ns_(0.0) {}
+
+void FrameLimiter::wait() {
+    if (frame_ns_ <= 0) return;
+    int64_t now = Timing::now_ns();
+    if (next_deadline_ns_ == 0 || now - next_deadline_ns_ > frame_ns_) {
+        // First frame, or we fell more than a frame behind: restart the schedule.
+        next_deadline_ns_ = now;
+    }
+    next_deadline_ns_ += frame_ns_;
+
+    int64_t sleep_ns = next_deadline_ns_ - now - static_cast<int64_t>(sleep_error_ns_);
+    if (sleep_ns > 0) {
+        int64_t before = now;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_ns));
+        now = Timing::now_ns();
+        double error = static_cast<double>(now - before - sleep_ns);
+        sleep_error_ns_ += (error - sleep_error_ns_) * Constants::FRAME_LIMITER_SMOOTHING;
+    }
+    while (now < next_deadline_ns_) {
+        std::this_thread::yield();
+        now = Timing::now_ns();
+    }
+    overshoot_ns_ += (static_cast<double>(now - next_deadline_ns_) - overshoot_ns_) * Constants::FRAME_LIMITER_SMOOTHING;
+}
+
+RateCounter::RateCounter(double window_seconds)
+    : window_ns_(static_cast<int64_t>(window_seconds * Constants::NANOSECONDS_PER_SECOND)),
+      window_start_ns_(0), count_(0), rate_(0.0) {}
+
+void RateCounter::add(int64_t now_ns, int64_t count) {
+    if (window_start_ns_ == 0) window_start_ns_ = now_ns;
+    count_ += count;
+    int64_t elapsed = now_ns - window_start_ns_;
+    if (elapsed >= window_ns_) {
+        rate_ = static_cast<double>(count_) * Constants::NANOSECONDS_PER_SECOND / static_cast<double>(elapsed);
+        count_ = 0;
+        window_start_ns_ = now_ns;
+    }
+}